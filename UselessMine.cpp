@@ -21,22 +21,80 @@
 */
 
 #include <algorithm>
-#include <functional>
-#include <map>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#ifdef __linux__
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
 
 #include "bzfsAPI.h"
 #include "plugin_files.h"
+#include "UselessMineKernels.h"
 
 const int DEBUG_VERBOSITY = 4;
 
+// The number of players a player's mines have to kill, without the player dying, for death messages to be taken from
+// the "streak" category
+const int MINE_STREAK_KILLS = 3;
+
+// The number of seconds an explosion is remembered if the server never says its shot ended
+const double EXPLOSION_TIMEOUT = 30;
+
+// The longest kills are held back after the first death from an explosion, waiting for the rest of its victims, when
+// the server doesn't say the explosion's shot ended sooner. A shock wave lasts well under this with the default settings.
+const double KILL_ANNOUNCEMENT_WINDOW = 2;
+
+// The number of grid cells around a player searched for the nearest mine they could trigger when working out how long
+// their position doesn't need to be checked
+const int SLEEP_SEARCH_CELLS = 4;
+
+// Verbose debug messages and trace events are only formatted or recorded when the server's debug level asks for them.
+// Define USELESSMINE_DISABLE_TRACE when compiling to remove them entirely.
+#ifndef USELESSMINE_DISABLE_TRACE
+    #define TRACE_MESSAGE(...) \
+        do { if (bz_getDebugLevel() >= DEBUG_VERBOSITY) { bz_debugMessagef(DEBUG_VERBOSITY, __VA_ARGS__); } } while (0)
+    #define TRACE_EVENT(type, playerID, mineID, pos) \
+        traceLog.record(type, playerID, mineID, pos)
+#else
+    #define TRACE_MESSAGE(...) do { } while (0)
+    #define TRACE_EVENT(type, playerID, mineID, pos) do { (void)(pos); } while (0)
+#endif
+
+// Event timings and mine check counters shown by `/minestats perf`. Define USELESSMINE_DISABLE_PERF when compiling to
+// remove them entirely.
+#ifndef USELESSMINE_DISABLE_PERF
+    #define PERF_SCOPE(section) \
+        PerfStats::Scope perfScope(perfStats, section)
+    #define PERF_COUNT(counter, amount) \
+        perfStats.counters[(int)PerfStats::Counter::counter] += (amount)
+    #define PERF_BUFFER(buffer, before) \
+        do { if ((buffer).capacity() != (before)) { PERF_COUNT(BufferGrowths, 1); } } while (0)
+#else
+    #define PERF_SCOPE(section) do { } while (0)
+    #define PERF_COUNT(counter, amount) do { (void)(amount); } while (0)
+    #define PERF_BUFFER(buffer, before) do { (void)(before); } while (0)
+#endif
+
 // Define plugin name
 const std::string PLUGIN_NAME = "Useless Mine";
 
 // Define plugin version numbering
 const int MAJOR = 1;
-const int MINOR = 2;
-const int REV = 1;
-const int BUILD = 99;
+const int MINOR = 3;
+const int REV = 0;
+const int BUILD = 100;
 
 enum class ExplosionType
 {
@@ -54,640 +112,4706 @@ public:
     virtual void Cleanup(void);
     virtual bool SlashCommand(int, bz_ApiString, bz_ApiString, bz_APIStringList*);
 
-    typedef std::multimap< int, std::string, std::greater<int> > rmap;
+    // Server settings used while checking for mine triggers; these are cached since they're needed on every player
+    // update and only change on BZDB changes or a world reload
+    struct Settings
+    {
+        double shockRange;     // The distance from a mine, on each axis, where a player will trigger it
+        int safetyTime;        // The number of seconds after spawning where a player can't trigger mines
+        int checkInterval;     // Only check for triggered mines every Nth player update
+        double checkDistance;  // Only check for triggered mines once a player moved this far
+        double maxTankSpeed;   // The fastest a tank can drive; anything faster is a teleport or respawn
+        bool tickChecks;       // Check for triggered mines once per server tick instead of on every player update
+        int lifetime;          // The number of seconds a mine stays on the field; 0 keeps mines forever
+        int maxPerPlayer;      // The most mines a single player may have on the field; 0 for no limit
+        int maxTotal;          // The most mines allowed on the field at once; 0 for no limit
+        std::string perfLogFile; // The file performance statistics are appended to; empty to not write them
+        int perfLogInterval;   // The number of seconds between writes to perfLogFile
+        bool workerThread;     // Check for triggered mines on a background thread
+        std::string analyticsFile; // The file mine activity is logged to; empty to not log it
+        bz_eGameType gameType; // The game mode the server is running
+
+        Settings() :
+            shockRange(0),
+            safetyTime(0),
+            checkInterval(1),
+            checkDistance(0),
+            maxTankSpeed(0),
+            tickChecks(false),
+            lifetime(0),
+            maxPerPlayer(0),
+            maxTotal(0),
+            perfLogInterval(0),
+            workerThread(false),
+            gameType(eTeamFFAGame)
+        {
+        }
+    };
+
+    // The information about a player needed while checking for mine triggers; this is kept up to date by events so the
+    // player update hot path never needs to fetch a player record
+    struct PlayerState
+    {
+        bool connected;        // True if a player is using this slot
+        bool spawned;          // True if the player is alive
+        bool hasDefusal;       // True if the player is carrying the Bomb Defusal flag
+        bz_eTeamType team;     // The team the player last joined or spawned as
+        double spawnTime;      // The time a player spawned last; used for _mineSafetyTime calculations
+        int mineKills;         // The number of players this player's mines killed since they last died
+
+        // Mine checks test the path a player took since the last check so skipped updates can't skip over a mine
+        bool hasCheckedPos;              // False if the next check should only test the player's current position
+        float checkedPos[3];             // The end of the path that's known not to touch a mine
+        double checkedTime;              // The time the player was at checkedPos
+        unsigned int updatesSinceCheck;  // The number of updates since the last check
+        double distanceSinceCheck;       // How far the player drove since the last check
+        unsigned int checkedMineVersion; // The mine field version during the last check
+        bool checkedInSafetyTime;        // True if the last check happened within _mineSafetyTime
+
+        bool hasPendingPos;              // True if the player has moved since the last server tick
+        float pendingPos[3];             // The player's latest position, waiting to be checked on the next tick
+
+        float clearancePos[3];           // The position `clearance` was measured from
+        double clearance;                // How far the player was from every mine they could trigger at that position
+        double sleepUntil;               // The earliest the player could reach one of those mines without teleporting
+
+        PlayerState() :
+            connected(false),
+            spawned(false),
+            hasDefusal(false),
+            team(eNoTeam),
+            spawnTime(-1),
+            mineKills(0),
+            hasCheckedPos(false),
+            checkedPos(),
+            checkedTime(0),
+            updatesSinceCheck(0),
+            distanceSinceCheck(0),
+            checkedMineVersion(0),
+            checkedInSafetyTime(false),
+            hasPendingPos(false),
+            pendingPos(),
+            clearancePos(),
+            clearance(0),
+            sleepUntil(0)
+        {
+        }
+    };
+
+    // Mines are referred to by a handle made of their slot in the mine store and the generation of that slot, so a
+    // handle to a removed mine will never match a newer mine that reused its slot
+    typedef uint32_t MineHandle;
 
-    // The information each mine will contain
-    struct Mine
+    // The information for every mine currently on the field, stored as parallel arrays so checking for triggers only
+    // touches the data it needs. Mines are kept densely packed; removing a mine moves the last mine into its place.
+    class MineStore
     {
-        static const char* ww_shotType;
-        static const char* ww_shotOwner;
-        static const char* ww_mineOwner;
+    public:
+        static const unsigned int MAX_MINES = 0xFFFF;
+        static const int MAX_PLAYERS = 256;
+        static const int MAX_TEAMS = eAdministrators + 1;
+
+        static const MineHandle INVALID_HANDLE = 0xFFFFFFFF;
+
+        MineStore() :
+            ownerCount(),
+            teamCount(),
+            oldestSlot(NO_SLOT),
+            newestSlot(NO_SLOT)
+        {
+            for (int i = 0; i < MAX_PLAYERS; i++)
+            {
+                oldestOwnedSlot[i] = newestOwnedSlot[i] = NO_SLOT;
+            }
+        }
+
+        std::vector<float> x, y, z;         // The coordinates of where the mine was placed
+        std::vector<bz_eTeamType> team;     // The team of the mine owner
+        std::vector<int> owner;             // The owner of the mine
+        std::vector<unsigned int> seq;      // The order in which the mine was placed
+        std::vector<MineHandle> handle;     // The handle of the mine
+        std::vector<double> placedAt;       // The time the mine was placed
+        std::vector<double> expiresAt;      // The time the mine will be removed on its own
+
+        unsigned int size() const
+        {
+            return (unsigned int)owner.size();
+        }
+
+        int countForOwner(int playerID) const
+        {
+            return ownerCount[playerID];
+        }
+
+        int countForTeam(bz_eTeamType _team) const
+        {
+            return isCountedTeam(_team) ? teamCount[_team] : 0;
+        }
+
+        // Mines owned by players without a real team, such as eNoTeam, are kept but not counted for any team
+        static bool isCountedTeam(bz_eTeamType _team)
+        {
+            return (_team >= 0 && _team < MAX_TEAMS);
+        }
+
+        bool isFull() const
+        {
+            return freeSlots.empty() && slotIndex.size() >= MAX_MINES;
+        }
+
+        bool isValid(MineHandle mine) const
+        {
+            unsigned int slot = mine & 0xFFFF;
+
+            return (slot < slotIndex.size() && slotIndex[slot] != NO_INDEX && slotGeneration[slot] == (mine >> 16));
+        }
 
-        bz_ApiString uid;      // A unique ID for mine
+        // Get the position of a mine in the mine arrays; the handle must be valid
+        unsigned int indexOf(MineHandle mine) const
+        {
+            return slotIndex[mine & 0xFFFF];
+        }
 
-        int owner;             // The owner of the mine
-        int defuserID;         // The player who defused this mine
-        uint32_t detonationShotID; // The GUID of the server shot, whether it's
-        float x, y, z;         // The coordinates of where the mine was placed
-        bz_eTeamType team;     // The team of the mine owner
-        bool defused;          // True if the mine was defused with a Bomb Defusal flag
-        bool detonated;        // True if the mine was detonated by a player
+        void reserve(size_t count)
+        {
+            x.reserve(count);
+            y.reserve(count);
+            z.reserve(count);
+            team.reserve(count);
+            owner.reserve(count);
+            seq.reserve(count);
+            handle.reserve(count);
+            placedAt.reserve(count);
+            expiresAt.reserve(count);
+        }
 
-        Mine(int _owner, float _pos[3], bz_eTeamType _team) :
-            owner(_owner),
-            defuserID(-1),
-            x(_pos[0]),
-            y(_pos[1]),
-            z(_pos[2]),
-            team(_team),
-            defused(false),
-            detonated(false)
+        // Get the mine that was placed first
+        MineHandle oldest() const
         {
-            uid.format("%d_%d_%d", owner, bz_getCurrentTime(), rand() % 32);
+            return handleOf(oldestSlot);
         }
 
-        bool isStale()
+        // Get the mine a player placed first
+        MineHandle oldestOwnedBy(int playerID) const
         {
-            return (defused || detonated);
+            return handleOf(oldestOwnedSlot[playerID]);
         }
 
-        // Should a given player trigger this mine?
-        // This function checks mine ownership, team loyalty, player's location and player's alive-ness
-        bool canPlayerTriggerMine(bz_BasePlayerRecord *pr, float pos[3])
+        MineHandle add(unsigned int _seq, int _owner, const float _pos[3], bz_eTeamType _team, double _placedAt, double _expiresAt)
         {
-            if (owner != pr->playerID && (pr->team == eRogueTeam || pr->team != team || bz_getGameType() == eOpenFFAGame) && pr->spawned)
+            unsigned int slot;
+
+            if (freeSlots.empty())
             {
-                float  playerPos[3] = {pos[0], pos[1], pos[2]};
-                double shockRange   = bz_getBZDBDouble("_shockOutRadius") * 0.75;
+                slot = (unsigned int)slotIndex.size();
+                slotIndex.push_back(0);
+                slotGeneration.push_back(0);
+            }
+            else
+            {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+            }
 
-                // Check if the player is in the detonation range
-                bool inDetonationRange = ((playerPos[0] > x - shockRange && playerPos[0] < x + shockRange) &&
-                                          (playerPos[1] > y - shockRange && playerPos[1] < y + shockRange) &&
-                                          (playerPos[2] > z - shockRange && playerPos[2] < z + shockRange));
+            MineHandle mine = ((MineHandle)slotGeneration[slot] << 16) | slot;
+            slotIndex[slot] = size();
 
-                return inDetonationRange;
+            linkNewest(slot, _owner);
+
+            x.push_back(_pos[0]);
+            y.push_back(_pos[1]);
+            z.push_back(_pos[2]);
+            team.push_back(_team);
+            owner.push_back(_owner);
+            seq.push_back(_seq);
+            handle.push_back(mine);
+            placedAt.push_back(_placedAt);
+            expiresAt.push_back(_expiresAt);
+
+            ownerCount[_owner]++;
+
+            if (isCountedTeam(_team))
+            {
+                teamCount[_team]++;
             }
 
-            return false;
+            return mine;
         }
 
-        // This sets the mine for defusal - the mine will trigger, but
-        // will instead trigger at the location of the owner, with the
-        // killer ID being that of the defuser.
-        bool defuse(int playerID)
+        void remove(MineHandle mine)
         {
-            if (defused || detonated)
+            unsigned int slot = mine & 0xFFFF;
+            unsigned int i = slotIndex[slot];
+            unsigned int last = size() - 1;
+
+            ownerCount[owner[i]]--;
+
+            if (isCountedTeam(team[i]))
             {
-                return false;
+                teamCount[team[i]]--;
             }
 
-            bz_BasePlayerRecord *pr = bz_getPlayerByIndex(owner);
+            unlink(slot, owner[i]);
+
+            if (i != last)
+            {
+                x[i] = x[last];
+                y[i] = y[last];
+                z[i] = z[last];
+                team[i] = team[last];
+                owner[i] = owner[last];
+                seq[i] = seq[last];
+                handle[i] = handle[last];
+                placedAt[i] = placedAt[last];
+                expiresAt[i] = expiresAt[last];
+
+                slotIndex[handle[i] & 0xFFFF] = i;
+            }
+
+            x.pop_back();
+            y.pop_back();
+            z.pop_back();
+            team.pop_back();
+            owner.pop_back();
+            seq.pop_back();
+            handle.pop_back();
+            placedAt.pop_back();
+            expiresAt.pop_back();
+
+            slotIndex[slot] = NO_INDEX;
+            slotGeneration[slot]++;
+            freeSlots.push_back(slot);
+        }
+
+        // Should a given player trigger this mine by moving from one position to another?
+        // This function checks mine ownership, team loyalty, player's path and player's alive-ness
+        bool canPlayerTriggerMine(unsigned int i, int playerID, const PlayerState &player, const float from[3], const float to[3], const Settings &settings) const
+        {
+            return player.spawned && selectTriggerTest(settings.gameType, player.team)(*this, i, playerID, player.team, from, to, settings.shockRange);
+        }
 
-            if (!pr || pr->team == eObservers)
+        // The ownership, team and path checks for a player who is alive. The team rule only depends on the game mode and
+        // the player's team, neither of which change between checks, so a version is compiled for each rule and the right
+        // one is picked ahead of time instead of testing the game mode for every mine.
+        typedef bool (*TriggerTest)(const MineStore &mines, unsigned int i, int playerID, int playerTeam, const float from[3],
+                                    const float to[3], double shockRange);
+
+        template <bool ANY_TEAM>
+        static bool triggerTest(const MineStore &mines, unsigned int i, int playerID, int playerTeam, const float from[3],
+                                const float to[3], double shockRange)
+        {
+            if (mines.owner[i] == playerID || (!ANY_TEAM && mines.team[i] == playerTeam))
             {
-                bz_freePlayerRecord(pr);
                 return false;
             }
 
-            bz_debugMessagef(DEBUG_VERBOSITY, "DEBUG :: Useless Mine :: Mine UID %s defused by %d", uid.c_str(), playerID);
+            return mines.isInTriggerBox(i, to, shockRange) || mines.isPathInTriggerBox(i, from, to, shockRange);
+        }
+
+        // Everyone's mines are fair game in Open FFA and for rogues; otherwise, such as in team FFA, CTF or rabbit chase,
+        // a player's own team's mines are safe
+        static TriggerTest selectTriggerTest(bz_eGameType gameType, bz_eTeamType playerTeam)
+        {
+            return (gameType == eOpenFFAGame || playerTeam == eRogueTeam) ? triggerTest<true> : triggerTest<false>;
+        }
+
+        bool isInTriggerBox(unsigned int i, const float pos[3], double shockRange) const
+        {
+            return ((pos[0] > x[i] - shockRange && pos[0] < x[i] + shockRange) &&
+                    (pos[1] > y[i] - shockRange && pos[1] < y[i] + shockRange) &&
+                    (pos[2] > z[i] - shockRange && pos[2] < z[i] + shockRange));
+        }
 
-            defused = true;
-            defuserID = playerID;
+        // Check whether the straight line between two positions passes through a mine's trigger box by clipping the
+        // line against the box one axis at a time
+        bool isPathInTriggerBox(unsigned int i, const float from[3], const float to[3], double shockRange) const
+        {
+            const float center[3] = {x[i], y[i], z[i]};
+            double enter = 0, exit = 1;
 
-            float vector[3] = {0, 0, 0};
-            int explosionType = (int)ExplosionType::Defusal;
-            detonationShotID = bz_fireServerShot("SW", pr->lastKnownState.pos, vector, bz_getPlayerTeam(defuserID));
-            bz_setShotMetaData(detonationShotID, ww_shotType, explosionType);
-            bz_setShotMetaData(detonationShotID, ww_shotOwner, defuserID);
-            bz_setShotMetaData(detonationShotID, ww_mineOwner, owner);
+            for (int axis = 0; axis < 3; axis++)
+            {
+                double low = center[axis] - shockRange, high = center[axis] + shockRange;
+                double delta = (double)to[axis] - from[axis];
 
-            bz_freePlayerRecord(pr);
+                if (delta == 0)
+                {
+                    if (!(from[axis] > low && from[axis] < high))
+                    {
+                        return false;
+                    }
+
+                    continue;
+                }
+
+                double t0 = (low - from[axis]) / delta, t1 = (high - from[axis]) / delta;
+
+                if (t0 > t1)
+                {
+                    std::swap(t0, t1);
+                }
+
+                enter = std::max(enter, t0);
+                exit = std::min(exit, t1);
+
+                if (enter >= exit)
+                {
+                    return false;
+                }
+            }
 
             return true;
         }
 
-        // This sets the mine for detonation - the mine will trigger,
-        // killing the victim and setting the killer as the mine
-        // owner.
-        bool detonate()
+    private:
+        static const unsigned int NO_INDEX = 0xFFFFFFFF;
+        static const unsigned int NO_SLOT = 0xFFFFFFFF;
+
+        MineHandle handleOf(unsigned int slot) const
+        {
+            return (slot == NO_SLOT) ? INVALID_HANDLE : (((MineHandle)slotGeneration[slot] << 16) | slot);
+        }
+
+        // Add a slot to the end of the placement order lists
+        void linkNewest(unsigned int slot, int _owner)
         {
-            if (detonated || defused || bz_getPlayerTeam(owner) == eObservers)
+            if (slot >= newerSlot.size())
             {
-                return false;
+                olderSlot.resize(slot + 1);
+                newerSlot.resize(slot + 1);
+                olderOwnedSlot.resize(slot + 1);
+                newerOwnedSlot.resize(slot + 1);
             }
 
-            detonated = true;
-
-            float minePos[3] = {x, y, z};
-            float vector[3] = {0, 0, 0};
+            olderSlot[slot] = newestSlot;
+            newerSlot[slot] = NO_SLOT;
+            (newestSlot == NO_SLOT ? oldestSlot : newerSlot[newestSlot]) = slot;
+            newestSlot = slot;
 
-            bz_debugMessagef(DEBUG_VERBOSITY, "DEBUG :: Useless Mine :: Mine UID %s detonated", uid.c_str());
+            olderOwnedSlot[slot] = newestOwnedSlot[_owner];
+            newerOwnedSlot[slot] = NO_SLOT;
+            (newestOwnedSlot[_owner] == NO_SLOT ? oldestOwnedSlot[_owner] : newerOwnedSlot[newestOwnedSlot[_owner]]) = slot;
+            newestOwnedSlot[_owner] = slot;
+        }
 
-            // Fire the world weapon
-            int explosionType = (int)ExplosionType::Mine;
-            detonationShotID = bz_fireServerShot("SW", minePos, vector, team);
-            bz_setShotMetaData(detonationShotID, ww_shotType, explosionType);
-            bz_setShotMetaData(detonationShotID, ww_shotOwner, owner);
-            bz_setShotMetaData(detonationShotID, ww_mineOwner, owner);
+        // Remove a slot from the placement order lists
+        void unlink(unsigned int slot, int _owner)
+        {
+            (olderSlot[slot] == NO_SLOT ? oldestSlot : newerSlot[olderSlot[slot]]) = newerSlot[slot];
+            (newerSlot[slot] == NO_SLOT ? newestSlot : olderSlot[newerSlot[slot]]) = olderSlot[slot];
 
-            return true;
+            (olderOwnedSlot[slot] == NO_SLOT ? oldestOwnedSlot[_owner] : newerOwnedSlot[olderOwnedSlot[slot]]) = newerOwnedSlot[slot];
+            (newerOwnedSlot[slot] == NO_SLOT ? newestOwnedSlot[_owner] : olderOwnedSlot[newerOwnedSlot[slot]]) = olderOwnedSlot[slot];
         }
+
+        std::vector<unsigned int> slotIndex;    // The position in the mine arrays of the mine using each slot
+        std::vector<uint16_t> slotGeneration;   // The number of times each slot has been reused
+        std::vector<unsigned int> freeSlots;    // Slots that are not used by any mine
+
+        int ownerCount[MAX_PLAYERS];            // The number of mines each player has on the field
+        int teamCount[MAX_TEAMS];               // The number of mines each team has on the field
+
+        // Doubly linked lists of slots in the order their mines were placed, for all mines and for each owner's mines
+        std::vector<unsigned int> olderSlot, newerSlot;
+        std::vector<unsigned int> olderOwnedSlot, newerOwnedSlot;
+        unsigned int oldestSlot, newestSlot;
+        unsigned int oldestOwnedSlot[MAX_PLAYERS], newestOwnedSlot[MAX_PLAYERS];
     };
 
-private:
-    int getMineCount();
+    // A mine in the spatial grid, stored with its placement order so query results can be sorted without a lookup
+    typedef std::pair<unsigned int, MineHandle> GridEntry;
 
-    void loadConfiguration(const char* commandline);
-    void reloadDeathMessages();
-    void reloadDefusalMessages();
-    void removePlayerMines(int playerID);
-    void removeMine(Mine &mine);
-    void sendDefuseMessage(int defuserID, int mineOwnerID, int victimID);
-    void sendDeathMessage(int mineOwner, int victimID);
-    void setMine(int owner, float pos[3], bz_eTeamType team);
+    // A uniform grid bucketing mines by their X/Y position. Each cell is as wide as a mine's trigger radius so a
+    // player can only ever trigger mines stored in their own cell or one of the neighbouring cells. Within a cell, mines
+    // are split up by the team that placed them and each team keeps a packed copy of its mines' positions, owners and
+    // teams so it can be filtered with a vectorized kernel. A query only looks at the teams hostile to the player, so
+    // friendly mines are never scanned.
+    class MineGrid
+    {
+    public:
+        // Team values range from eNoTeam (-1) upwards; anything out of range shares the last partition
+        static const int MAX_PARTITIONS = 16;
 
-    std::string formatMineMessage(std::string msg, std::string mineOwner, std::string defuserOrVictim);
-    std::string parsePath(bz_ApiString path);
+        MineGrid() :
+            cellSize(0),
+            kernel(findNearbyMinesScalar)
+        {
+            setGameType(eTeamFFAGame);
+        }
 
-    std::vector<std::string> deathMessages; // A vector that will store all of the witty death messages
-    std::vector<std::string> defusalMessages; // A vector that will store all of the witty defusal messages
+        double getCellSize() const
+        {
+            return cellSize;
+        }
 
-    std::vector<Mine> activeMines; // A vector that will store all of the mines currently on the field
-    std::string deathMessagesFile; // The path to the file containing death messages
-    std::string defusalMessagesFile; // The path to the file containing defusal messages
-    double playerSpawnTime[256]; // The time a player spawned last; used for _mineSafetyTime calculations
+        void setKernel(ProximityKernel _kernel)
+        {
+            kernel = _kernel;
+        }
 
-    const char* bzdb_safetyTime = "_mineSafetyTime";
-};
+        // Work out which teams' mines can be triggered by each team; this only changes with the game mode
+        void setGameType(bz_eGameType gameType)
+        {
+            for (int player = 0; player < MAX_PARTITIONS; player++)
+            {
+                hostilePartitions[player] = 0;
 
-BZ_PLUGIN(UselessMine)
+                for (int mine = 0; mine < MAX_PARTITIONS; mine++)
+                {
+                    // Matches the team rule in MineStore::selectTriggerTest
+                    if (gameType == eOpenFFAGame || player == partitionIndex(eRogueTeam) || player != mine)
+                    {
+                        hostilePartitions[player] |= (1u << mine);
+                    }
+                }
+            }
+        }
 
-const char* UselessMine::Mine::ww_shotType = "shotType";
-const char* UselessMine::Mine::ww_shotOwner = "shotOwner";
-const char* UselessMine::Mine::ww_mineOwner = "mineOwner";
+        void reset(double _cellSize)
+        {
+            cellSize = _cellSize;
+            cells.clear();
+        }
 
-const char* UselessMine::Name(void)
-{
-    static std::string pluginName;
+        // Insert every mine from a position in the store onwards, sizing each partition once instead of growing it a
+        // mine at a time; used when a large number of mines appear at once
+        void insertAll(const MineStore &store, unsigned int first)
+        {
+            if (cellSize <= 0 || first >= store.size())
+            {
+                return;
+            }
 
-    if (pluginName.empty())
-    {
-        pluginName = bz_format("%s %d.%d.%d (%d)", PLUGIN_NAME.c_str(), MAJOR, MINOR, REV, BUILD);
-    }
+            typedef std::pair<long long, int> PartitionKey;
+            std::vector<std::pair<PartitionKey, unsigned int>> keys;
+            keys.reserve(store.size() - first);
 
-    return pluginName.c_str();
-}
+            for (unsigned int i = first; i < store.size(); i++)
+            {
+                PartitionKey key(cellKey(cellIndex(store.x[i]), cellIndex(store.y[i])), partitionIndex(store.team[i]));
+                keys.push_back(std::make_pair(key, i));
+            }
 
-void UselessMine::Init(const char* commandLine)
-{
-    Register(bz_eFlagGrabbedEvent);
-    Register(bz_ePlayerDieEvent);
-    Register(bz_ePlayerPartEvent);
-    Register(bz_ePlayerSpawnEvent);
-    Register(bz_ePlayerUpdateEvent);
+            std::sort(keys.begin(), keys.end());
+            cells.reserve(cells.size() + keys.size());
 
-    bz_registerCustomSlashCommand("mine", this);
-    bz_registerCustomSlashCommand("minecount", this);
-    bz_registerCustomSlashCommand("minestats", this);
-    bz_registerCustomSlashCommand("reload", this);
+            for (size_t run = 0, end; run < keys.size(); run = end)
+            {
+                for (end = run + 1; end < keys.size() && keys[end].first == keys[run].first; end++);
 
-    bz_RegisterCustomFlag("BD", "Bomb Defusal", "Safely defuse enemy mines while killing the mine owners", 0, eGoodFlag);
+                Partition &partition = cells[keys[run].first.first].get(keys[run].first.second);
+                size_t count = partition.entries.size() + (end - run);
 
-    bz_registerCustomBZDBInt(bzdb_safetyTime, 5);
+                partition.x.reserve(count);
+                partition.y.reserve(count);
+                partition.z.reserve(count);
+                partition.owner.reserve(count);
+                partition.team.reserve(count);
+                partition.entries.reserve(count);
 
-    loadConfiguration(commandLine);
+                for (size_t k = run; k < end; k++)
+                {
+                    partition.add(store, keys[k].second);
+                }
+            }
+        }
 
-    reloadDeathMessages();
-    reloadDefusalMessages();
+        void insert(const MineStore &store, unsigned int i)
+        {
+            if (cellSize <= 0)
+            {
+                return;
+            }
 
-    if (deathMessages.empty())
-    {
-        bz_debugMessage(2, "WARNING :: Useless Mine :: No witty death messages were loaded");
-    }
-    else
-    {
-        bz_debugMessagef(2, "DEBUG :: Useless Mine :: %d witty death messages were loaded", deathMessages.size());
-    }
+            cells[cellKey(cellIndex(store.x[i]), cellIndex(store.y[i]))].get(partitionIndex(store.team[i])).add(store, i);
+        }
 
-    if (defusalMessages.empty())
-    {
-        bz_debugMessage(2, "WARNING :: Useless Mine :: No witty defusal messages were loaded");
-    }
-    else
-    {
-        bz_debugMessagef(2, "DEBUG :: Useless Mine :: %d witty defusal messages were loaded", defusalMessages.size());
-    }
-}
+        void remove(MineHandle mine, float x, float y, int team)
+        {
+            if (cellSize <= 0)
+            {
+                return;
+            }
 
-void UselessMine::Cleanup(void)
-{
-    Flush();
+            auto it = cells.find(cellKey(cellIndex(x), cellIndex(y)));
 
-    bz_removeCustomSlashCommand("mine");
-    bz_removeCustomSlashCommand("minecount");
-    bz_removeCustomSlashCommand("minestats");
-    bz_removeCustomSlashCommand("reload");
+            if (it == cells.end())
+            {
+                return;
+            }
 
-    bz_removeCustomBZDBVariable(bzdb_safetyTime);
-}
+            Cell &cell = it->second;
+            int index = partitionIndex(team);
 
-void UselessMine::Event(bz_EventData *eventData)
-{
-    switch (eventData->eventType)
-    {
-        case bz_eFlagGrabbedEvent:
+            for (size_t p = 0; p < cell.partitions.size(); p++)
+            {
+                if (cell.partitions[p].index != index)
+                {
+                    continue;
+                }
+
+                if (cell.partitions[p].remove(mine) && cell.partitions[p].entries.empty())
+                {
+                    cell.partitions[p] = std::move(cell.partitions.back());
+                    cell.partitions.pop_back();
+                }
+
+                break;
+            }
+
+            if (cell.partitions.empty())
+            {
+                cells.erase(it);
+            }
+        }
+
+        // Collect every mine a player could trigger moving between two positions, sorted in placement order so callers
+        // visit them in the same order as a linear scan would; returns the number of mines in the partitions searched
+        unsigned int query(const float from[3], const float to[3], int playerID, bz_eTeamType team, std::vector<GridEntry> &out)
         {
-            bz_FlagGrabbedEventData_V1* flagGrabData = (bz_FlagGrabbedEventData_V1*)eventData;
+            out.clear();
 
-            // If the user grabbed the Useless flag, let them know they can place a mine
-            if (strcmp(flagGrabData->flagType, "US") == 0)
+            if (cellSize <= 0 || cells.empty())
             {
-                bz_sendTextMessage(BZ_SERVER, flagGrabData->playerID, "You grabbed a Useless flag! Type /mine at any time to set a useless mine!");
+                return 0;
+            }
+
+            unsigned int scanned = 0;
+            uint32_t hostile = hostilePartitions[partitionIndex(team)];
+
+            // Pad the bounds to absorb any float rounding; the exact trigger test is done by the caller
+            float padding = (float)cellSize + 0.01f;
+
+            // Only hostile partitions are scanned, so the kernel doesn't need to check teams again
+            ProximityQuery proximity;
+            proximity.playerID = playerID;
+            proximity.team = team;
+            proximity.anyTeam = true;
+
+            for (int axis = 0; axis < 3; axis++)
+            {
+                proximity.min[axis] = std::min(from[axis], to[axis]) - padding;
+                proximity.max[axis] = std::max(from[axis], to[axis]) + padding;
+            }
+
+            int minX = cellIndex(std::min(from[0], to[0]) - cellSize), maxX = cellIndex(std::max(from[0], to[0]) + cellSize);
+            int minY = cellIndex(std::min(from[1], to[1]) - cellSize), maxY = cellIndex(std::max(from[1], to[1]) + cellSize);
+
+            for (int cx = minX; cx <= maxX; cx++)
+            {
+                for (int cy = minY; cy <= maxY; cy++)
+                {
+                    auto it = cells.find(cellKey(cx, cy));
+
+                    if (it == cells.end())
+                    {
+                        continue;
+                    }
+
+                    for (const Partition &partition : it->second.partitions)
+                    {
+                        if (!(hostile & (1u << partition.index)))
+                        {
+                            continue;
+                        }
+
+                        unsigned int count = (unsigned int)partition.entries.size();
+                        scanned += count;
+
+                        if (hits.size() < count)
+                        {
+                            hits.resize(count);
+                        }
+
+                        unsigned int found = kernel(partition.x.data(), partition.y.data(), partition.z.data(), partition.owner.data(),
+                                                    partition.team.data(), count, proximity, hits.data());
+
+                        for (unsigned int i = 0; i < found; i++)
+                        {
+                            out.push_back(partition.entries[hits[i]]);
+                        }
+                    }
+                }
             }
+
+            std::sort(out.begin(), out.end());
+
+            return scanned;
         }
-        break;
 
-        case bz_ePlayerDieEvent:
+        // Find how far, on the X/Y plane, a player is from the trigger box of the nearest mine they could set off. Only
+        // the cells up to `radius` cells away are searched, so the result is capped at the distance any mine outside of them
+        // has to be. `scanned` is set to the number of cells looked up.
+        double hostileClearance(const float pos[3], int playerID, bz_eTeamType team, double shockRange, int radius, unsigned int &scanned) const
         {
-            bz_PlayerDieEventData_V1* dieData = (bz_PlayerDieEventData_V1*)eventData;
+            scanned = 0;
 
-            int victimID = dieData->playerID;
-            uint32_t shotGUID = bz_getShotGUID(dieData->killerID, dieData->shotID);
+            if (cellSize <= 0)
+            {
+                return 0;
+            }
+
+            uint32_t hostile = hostilePartitions[partitionIndex(team)];
+            int centerX = cellIndex(pos[0]), centerY = cellIndex(pos[1]);
+            double clearance = radius * cellSize - shockRange;
+
+            // Search outwards a ring of cells at a time. A mine in ring N is at least N - 1 cells away, so the search
+            // stops once no ring further out could have a closer mine than the closest one found so far.
+            for (int ring = 0; ring <= radius && clearance > (ring - 1) * cellSize - shockRange; ring++)
+            {
+                for (int cx = centerX - ring; cx <= centerX + ring; cx++)
+                {
+                    // Only the first and last columns of a ring are full; the others only have their top and bottom cells
+                    int step = (cx == centerX - ring || cx == centerX + ring) ? 1 : 2 * ring;
+
+                    for (int cy = centerY - ring; cy <= centerY + ring; cy += step)
+                    {
+                        scanned++;
+
+                        auto it = cells.find(cellKey(cx, cy));
+
+                        if (it == cells.end())
+                        {
+                            continue;
+                        }
+
+                        for (const Partition &partition : it->second.partitions)
+                        {
+                            if (!(hostile & (1u << partition.index)))
+                            {
+                                continue;
+                            }
+
+                            for (size_t i = 0; i < partition.entries.size(); i++)
+                            {
+                                if (partition.owner[i] == playerID)
+                                {
+                                    continue;
+                                }
+
+                                double distance = std::max(std::fabs(partition.x[i] - pos[0]), std::fabs(partition.y[i] - pos[1])) - shockRange;
+                                clearance = std::min(clearance, distance);
+                            }
+                        }
+                    }
+                }
+            }
+
+            return std::max(0.0, clearance);
+        }
+
+    private:
+        // The mines in one cell placed by one team
+        struct Partition
+        {
+            int index;
+            std::vector<float> x, y, z;
+            std::vector<int> owner;
+            std::vector<int> team;
+            std::vector<GridEntry> entries;
+
+            void add(const MineStore &store, unsigned int i)
+            {
+                x.push_back(store.x[i]);
+                y.push_back(store.y[i]);
+                z.push_back(store.z[i]);
+                owner.push_back(store.owner[i]);
+                team.push_back(store.team[i]);
+                entries.push_back(GridEntry(store.seq[i], store.handle[i]));
+            }
+
+            bool remove(MineHandle mine)
+            {
+                for (size_t i = 0; i < entries.size(); i++)
+                {
+                    if (entries[i].second != mine)
+                    {
+                        continue;
+                    }
+
+                    // Results are sorted by placement order when queried, so the order within a partition doesn't matter
+                    x[i] = x.back();
+                    y[i] = y.back();
+                    z[i] = z.back();
+                    owner[i] = owner.back();
+                    team[i] = team.back();
+                    entries[i] = entries.back();
+
+                    x.pop_back();
+                    y.pop_back();
+                    z.pop_back();
+                    owner.pop_back();
+                    team.pop_back();
+                    entries.pop_back();
+
+                    return true;
+                }
+
+                return false;
+            }
+        };
+
+        // A cell only holds partitions for the teams that have mines in it, which is rarely more than a few
+        struct Cell
+        {
+            std::vector<Partition> partitions;
+
+            Partition& get(int index)
+            {
+                for (Partition &partition : partitions)
+                {
+                    if (partition.index == index)
+                    {
+                        return partition;
+                    }
+                }
+
+                partitions.push_back(Partition());
+                partitions.back().index = index;
+
+                return partitions.back();
+            }
+        };
+
+        static int partitionIndex(int team)
+        {
+            return std::max(0, std::min(team + 1, MAX_PARTITIONS - 1));
+        }
+
+        int cellIndex(double coord) const
+        {
+            return (int)std::floor(coord / cellSize);
+        }
+
+        static long long cellKey(int cx, int cy)
+        {
+            return (long long)(((unsigned long long)(unsigned int)cx << 32) | (unsigned int)cy);
+        }
+
+        double cellSize;
+        ProximityKernel kernel;
+        uint32_t hostilePartitions[MAX_PARTITIONS]; // For each team's partition, a bit set for every partition it can trigger
+        std::unordered_map<long long, Cell> cells;
+        std::vector<unsigned int> hits;     // Scratch space for kernel results
+    };
+
+    // A hierarchical timer wheel for mine expiry. Each level has 64 slots, with a slot on one level covering as much time
+    // as the whole level below it, so scheduling a mine and advancing time are O(1) no matter how many mines exist.
+    // Timers aren't cancelled when a mine is removed early; the handle is simply stale by the time the timer fires.
+    class TimerWheel
+    {
+    public:
+        TimerWheel() :
+            currentTick(0)
+        {
+        }
+
+        void reset(double now)
+        {
+            currentTick = elapsedTicks(now);
+
+            for (auto &level : slots)
+            {
+                for (auto &slot : level)
+                {
+                    slot.clear();
+                }
+            }
+        }
+
+        void schedule(MineHandle mine, double expiresAt)
+        {
+            schedule(Timer{mine, std::max(expiryTick(expiresAt), currentTick + 1)});
+        }
+
+        // Move time forward, collecting every mine whose timer fired
+        void advance(double now, std::vector<MineHandle> &expired)
+        {
+            long long target = elapsedTicks(now);
+
+            while (currentTick < target)
+            {
+                currentTick++;
+
+                // Move timers down a level once the level below has gone all the way around
+                for (int level = LEVELS - 1; level > 0; level--)
+                {
+                    if ((currentTick & ((1LL << (BITS * level)) - 1)) == 0)
+                    {
+                        cascade(level, (currentTick >> (BITS * level)) & (SLOTS - 1));
+                    }
+                }
+
+                std::vector<Timer> &slot = slots[0][currentTick & (SLOTS - 1)];
+
+                for (const Timer &timer : slot)
+                {
+                    expired.push_back(timer.mine);
+                }
+
+                slot.clear();
+            }
+        }
+
+    private:
+        static const int LEVELS = 3;
+        static const int BITS = 6;
+        static const int SLOTS = 1 << BITS;
+
+        struct Timer
+        {
+            MineHandle mine;
+            long long tick;
+        };
+
+        // Timers have a resolution of a quarter second and are rounded up, so they never fire before the mine expires
+        static long long expiryTick(double time)
+        {
+            return (long long)std::ceil(time * 4);
+        }
+
+        static long long elapsedTicks(double time)
+        {
+            return (long long)std::floor(time * 4);
+        }
+
+        void schedule(const Timer &timer)
+        {
+            long long delta = timer.tick - currentTick;
+
+            for (int level = 0; level < LEVELS; level++)
+            {
+                if (delta < (1LL << (BITS * (level + 1))) || level == LEVELS - 1)
+                {
+                    // Timers further out than the top level can reach are parked there and rescheduled when cascaded
+                    long long tick = std::min(timer.tick, currentTick + (1LL << (BITS * LEVELS)) - 1);
+                    slots[level][(tick >> (BITS * level)) & (SLOTS - 1)].push_back(timer);
+                    return;
+                }
+            }
+        }
+
+        void cascade(int level, long long slot)
+        {
+            std::vector<Timer> timers;
+            timers.swap(slots[level][slot]);
+
+            for (const Timer &timer : timers)
+            {
+                schedule(timer);
+            }
+        }
+
+        std::vector<Timer> slots[LEVELS][SLOTS];
+        long long currentTick;
+    };
+
+    // A compact binary copy of the mine field, written when the plug-in is unloaded so the mines survive a reload. The
+    // file is a header, a table of mine owners and a table of fixed-size mine records in the order they were placed, all
+    // in the server's native byte order since it's only ever read back by the same server.
+    class MineSnapshot
+    {
+    public:
+        struct Owner
+        {
+            std::string callsign;
+            std::string bzID;
+        };
+
+        struct Mine
+        {
+            float pos[3];
+            float age;      // The number of seconds the mine had been on the field
+            uint16_t owner; // The position of the mine owner in the owner table
+            uint8_t team;
+            uint8_t unused;
+        };
+
+        std::vector<Owner> owners;
+        std::vector<Mine> mines;
+
+        bool save(const std::string &path) const
+        {
+            std::string buffer;
+            buffer.reserve(HEADER_SIZE + owners.size() * 40 + mines.size() * sizeof(Mine));
+
+            uint32_t header[4] = {MAGIC, VERSION, (uint32_t)owners.size(), (uint32_t)mines.size()};
+            buffer.append((const char*)header, sizeof(header));
+
+            for (const Owner &owner : owners)
+            {
+                appendString(buffer, owner.callsign);
+                appendString(buffer, owner.bzID);
+            }
+
+            if (!mines.empty())
+            {
+                buffer.append((const char*)&mines[0], mines.size() * sizeof(Mine));
+            }
+
+            FILE *file = fopen(path.c_str(), "wb");
+
+            if (!file)
+            {
+                return false;
+            }
+
+            bool written = (fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size());
+
+            return (fclose(file) == 0) && written;
+        }
+
+        // Read a snapshot with a single read of the whole file; returns false if it's missing, truncated or from an
+        // incompatible version of the plug-in
+        bool load(const std::string &path)
+        {
+            owners.clear();
+            mines.clear();
+
+            FILE *file = fopen(path.c_str(), "rb");
+
+            if (!file)
+            {
+                return false;
+            }
+
+            std::vector<char> buffer;
+
+            if (fseek(file, 0, SEEK_END) == 0)
+            {
+                long size = ftell(file);
+
+                if (size > 0 && fseek(file, 0, SEEK_SET) == 0)
+                {
+                    buffer.resize(size);
+
+                    if (fread(&buffer[0], 1, buffer.size(), file) != buffer.size())
+                    {
+                        buffer.clear();
+                    }
+                }
+            }
+
+            fclose(file);
+
+            uint32_t header[4];
+
+            if (buffer.size() < HEADER_SIZE)
+            {
+                return false;
+            }
+
+            memcpy(header, &buffer[0], sizeof(header));
+
+            if (header[0] != MAGIC || header[1] != VERSION)
+            {
+                return false;
+            }
+
+            size_t offset = HEADER_SIZE;
+            owners.resize(header[2]);
+
+            for (Owner &owner : owners)
+            {
+                if (!readString(buffer, offset, owner.callsign) || !readString(buffer, offset, owner.bzID))
+                {
+                    owners.clear();
+                    return false;
+                }
+            }
+
+            if ((buffer.size() - offset) != header[3] * sizeof(Mine))
+            {
+                owners.clear();
+                return false;
+            }
+
+            mines.resize(header[3]);
+
+            if (!mines.empty())
+            {
+                memcpy(&mines[0], &buffer[offset], mines.size() * sizeof(Mine));
+            }
+
+            return true;
+        }
+
+    private:
+        static const uint32_t MAGIC = 0x4E534D55; // "UMSN"
+        static const uint32_t VERSION = 1;
+        static const size_t HEADER_SIZE = 4 * sizeof(uint32_t);
+
+        static void appendString(std::string &buffer, const std::string &value)
+        {
+            uint8_t length = (uint8_t)std::min(value.size(), (size_t)255);
+
+            buffer.push_back((char)length);
+            buffer.append(value, 0, length);
+        }
+
+        static bool readString(const std::vector<char> &buffer, size_t &offset, std::string &value)
+        {
+            if (offset >= buffer.size() || buffer.size() - offset - 1 < (uint8_t)buffer[offset])
+            {
+                return false;
+            }
+
+            uint8_t length = (uint8_t)buffer[offset];
+            value.assign(&buffer[offset + 1], length);
+            offset += 1 + length;
+
+            return true;
+        }
+    };
+
+    // A fixed-size queue between exactly one producer thread and one consumer thread. Each side only ever writes its own
+    // index, so pushing and popping never take a lock. The capacity must be a power of two; one slot is kept empty to
+    // tell a full queue from an empty one.
+    template <typename T, size_t CAPACITY>
+    class SpscRing
+    {
+    public:
+        SpscRing() :
+            items(CAPACITY),
+            head(0),
+            tail(0)
+        {
+        }
+
+        // Called by the producer; returns false if the queue is full
+        bool push(const T &item)
+        {
+            size_t position = tail.load(std::memory_order_relaxed);
+            size_t next = (position + 1) & (CAPACITY - 1);
+
+            if (next == head.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            items[position] = item;
+            tail.store(next, std::memory_order_release);
+
+            return true;
+        }
+
+        // Called by the consumer; returns false if the queue is empty
+        bool pop(T &item)
+        {
+            size_t position = head.load(std::memory_order_relaxed);
+
+            if (position == tail.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            item = items[position];
+            head.store((position + 1) & (CAPACITY - 1), std::memory_order_release);
+
+            return true;
+        }
+
+        bool empty() const
+        {
+            return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+        }
+
+        // Only safe to call while neither thread is using the queue
+        void clear()
+        {
+            head.store(0);
+            tail.store(0);
+        }
+
+    private:
+        std::vector<T> items;
+        std::atomic<size_t> head; // Written by the consumer
+        char padding[64];         // Keeps the two indexes on separate cache lines
+        std::atomic<size_t> tail; // Written by the producer
+    };
+
+    // Checks player positions for triggered mines on a background thread. The worker keeps its own copy of the mine
+    // field, kept in sync by the same ordered queue that carries player positions, so a position is always checked
+    // against the mines that existed when it was sent. It can't call bzfsAPI, so it only reports the mines each position
+    // touched; the main thread decides what to do with them on the next tick.
+    class TriggerWorker
+    {
+    public:
+        struct Command
+        {
+            enum class Type
+            {
+                Configure,  // Use new server settings; rebuilds the worker's mine grid if the trigger radius changed
+                AddMine,    // A mine was placed at `to`
+                RemoveMine, // A mine was removed
+                Check       // Check the path a player took from `from` to `to`
+            };
+
+            Type type;
+            MineHandle mine;
+            unsigned int seq;
+            int playerID;           // The player being checked, or the owner of a new mine
+            bz_eTeamType team;
+            double spawnTime;       // The spawn of the player the check belongs to
+            float from[3];
+            float to[3];
+            double shockRange;
+            bz_eGameType gameType;
+        };
+
+        // A mine touched by a checked path. All of the hits for one check are sent together in placement order.
+        struct Hit
+        {
+            unsigned int check;     // Which check this hit came from
+            int playerID;
+            double spawnTime;
+            MineHandle mine;        // The main thread's handle for the mine
+            float from[3];
+            float to[3];
+        };
+
+        TriggerWorker() :
+            stopping(false),
+            sleeping(false),
+            nextCheck(0)
+        {
+        }
+
+        ~TriggerWorker()
+        {
+            stop();
+        }
+
+        bool isRunning() const
+        {
+            return thread.joinable();
+        }
+
+        void start(ProximityKernel kernel)
+        {
+            if (isRunning())
+            {
+                return;
+            }
+
+            // Forget the settings of any earlier run so the first Configure always builds the grid
+            mines = MineStore();
+            handles.clear();
+            mainHandles.clear();
+            settings = Settings();
+            grid.setKernel(kernel);
+            grid.setGameType(settings.gameType);
+            grid.reset(settings.shockRange);
+            commands.clear();
+            hits.clear();
+
+            stopping = false;
+            thread = std::thread(&TriggerWorker::run, this);
+        }
+
+        void stop()
+        {
+            if (!isRunning())
+            {
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+
+            signal.notify_one();
+            thread.join();
+
+            commands.clear();
+        }
+
+        // Queue a command for the worker; returns false if the queue is full
+        bool send(const Command &command)
+        {
+            if (!commands.push(command))
+            {
+                return false;
+            }
+
+            // Only take the lock when the worker is waiting for something to do. The fence pairs with the one in run()
+            // so either the worker sees this command before it sleeps or this thread sees that it's sleeping.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (sleeping.load(std::memory_order_relaxed))
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                }
+
+                signal.notify_one();
+            }
+
+            return true;
+        }
+
+        bool takeHit(Hit &hit)
+        {
+            return hits.pop(hit);
+        }
+
+    private:
+        void run()
+        {
+            Command command;
+
+            while (!stopping)
+            {
+                if (!commands.pop(command))
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+
+                    sleeping.store(true, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                    signal.wait(lock, [this]() {
+                        return stopping || !commands.empty();
+                    });
+
+                    sleeping.store(false, std::memory_order_relaxed);
+                    continue;
+                }
+
+                switch (command.type)
+                {
+                    case Command::Type::Configure:
+                        if (command.gameType != settings.gameType)
+                        {
+                            settings.gameType = command.gameType;
+                            grid.setGameType(settings.gameType);
+                        }
+
+                        if (command.shockRange != settings.shockRange)
+                        {
+                            settings.shockRange = command.shockRange;
+                            grid.reset(settings.shockRange);
+                            grid.insertAll(mines, 0);
+                        }
+                        break;
+
+                    case Command::Type::AddMine:
+                    {
+                        MineHandle mine = mines.add(command.seq, command.playerID, command.to, command.team, 0, 0);
+                        grid.insert(mines, mines.indexOf(mine));
+                        handles[command.mine] = mine;
+                        mainHandles[mine] = command.mine;
+                    }
+                    break;
+
+                    case Command::Type::RemoveMine:
+                    {
+                        auto it = handles.find(command.mine);
+
+                        if (it != handles.end())
+                        {
+                            unsigned int i = mines.indexOf(it->second);
+                            grid.remove(it->second, mines.x[i], mines.y[i], mines.team[i]);
+                            mines.remove(it->second);
+                            mainHandles.erase(it->second);
+                            handles.erase(it);
+                        }
+                    }
+                    break;
+
+                    case Command::Type::Check:
+                        check(command);
+                        break;
+                }
+            }
+        }
+
+        void check(const Command &command)
+        {
+            MineStore::TriggerTest canTrigger = MineStore::selectTriggerTest(settings.gameType, command.team);
+
+            grid.query(command.from, command.to, command.playerID, command.team, nearbyMines);
+
+            Hit hit;
+            hit.check = nextCheck++;
+            hit.playerID = command.playerID;
+            hit.spawnTime = command.spawnTime;
+            std::copy(command.from, command.from + 3, hit.from);
+            std::copy(command.to, command.to + 3, hit.to);
+
+            for (const GridEntry &entry : nearbyMines)
+            {
+                if (!canTrigger(mines, mines.indexOf(entry.second), command.playerID, command.team, command.from, command.to, settings.shockRange))
+                {
+                    continue;
+                }
+
+                hit.mine = mainHandles[entry.second];
+
+                // Wait for the main thread to make room rather than lose a detonation
+                while (!hits.push(hit) && !stopping)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        SpscRing<Command, 4096> commands;
+        SpscRing<Hit, 4096> hits;
+        std::thread thread;
+        std::atomic<bool> stopping;
+        std::atomic<bool> sleeping; // True while the worker is waiting on `signal` for a command
+        std::mutex mutex;
+        std::condition_variable signal;
+
+        // Only used by the worker thread while it's running
+        MineStore mines;
+        MineGrid grid;
+        Settings settings;
+        std::unordered_map<MineHandle, MineHandle> handles;     // From the main thread's handles to the worker's
+        std::unordered_map<MineHandle, MineHandle> mainHandles; // From the worker's handles to the main thread's
+        std::vector<GridEntry> nearbyMines;
+        unsigned int nextCheck;
+    };
+
+    // An append-only binary log of mine activity for studying how mines are used over many matches. Records are handed
+    // to a background thread through a lock-free queue so event handlers never wait on the disk; if the thread falls
+    // too far behind, records are dropped instead.
+    //
+    // The file starts with a header of two uint32s, MAGIC and VERSION. Each record after it is a uint8 RecordType, a
+    // uint8 payload size, and the payload; readers should skip record types they don't know. Every time the log is
+    // opened, a Session record is written; player IDs and mine numbers only mean something within their session.
+    class AnalyticsLog
+    {
+    public:
+        enum class RecordType : uint8_t
+        {
+            Session = 1,      // SessionRecord
+            Player,           // PlayerRecord followed by the callsign
+            MinePlaced,       // PlacedRecord
+            MineDetonated,    // TriggeredRecord
+            MineDefused,      // TriggeredRecord
+            MineRemoved,      // RemovedRecord
+            Kills             // KillsRecord
+        };
+
+        enum class RemoveReason : uint8_t
+        {
+            Expired = 0,      // The mine reached the end of _mineLifetime
+            Replaced,         // The mine was removed to make room for a newer one
+            OwnerLeft         // The mine's owner left the server
+        };
+
+        // Every record is padded to a multiple of 8 bytes so the layout is the same on every compiler the plug-in
+        // supports; UselessMineLogReader.cpp has a copy of these definitions that must be kept in sync
+        struct SessionRecord
+        {
+            int64_t startedAt;  // Seconds since the Unix epoch
+            double time;        // The server time the session started at; every other record uses server time
+            float worldSize;
+            uint8_t unused[4];
+        };
+
+        struct PlayerRecord
+        {
+            double time;
+            int16_t playerID;
+            uint8_t team;
+            uint8_t length;     // The length of the callsign following the record
+            uint8_t unused[4];
+        };
+
+        struct PlacedRecord
+        {
+            double time;
+            float pos[3];
+            uint32_t mine;
+            int16_t owner;
+            uint8_t team;
+            uint8_t unused[5];
+        };
+
+        struct TriggeredRecord
+        {
+            double time;
+            float pos[3];       // The position of the mine
+            uint32_t mine;
+            uint32_t shot;      // The GUID of the explosion, matching the Kills record for it
+            int16_t owner;
+            int16_t triggeredBy;
+        };
+
+        struct RemovedRecord
+        {
+            double time;
+            uint32_t mine;
+            uint8_t reason;
+            uint8_t unused[3];
+        };
+
+        struct KillsRecord
+        {
+            double time;
+            uint32_t shot;
+            int16_t shotOwner;
+            int16_t mineOwner;
+            uint8_t type;       // An ExplosionType
+            uint8_t ownerKilled;
+            uint8_t victims;    // The number of victims other than the mine owner, whose IDs follow the record
+            uint8_t unused[5];
+        };
+
+        // The most bytes a record and the data following it may take up
+        static const size_t MAX_RECORD_SIZE = 62;
+
+        AnalyticsLog() :
+            stopping(false),
+            file(nullptr),
+            dropped(0)
+        {
+        }
+
+        ~AnalyticsLog()
+        {
+            stop();
+        }
+
+        bool isRunning() const
+        {
+            return file != nullptr;
+        }
+
+        // Open a log to append to, writing the file header if the file is new; returns false if the file can't be
+        // opened or was written by an incompatible version of the plug-in
+        bool start(const std::string &path, double now, float worldSize)
+        {
+            stop();
+
+            FILE *existing = fopen(path.c_str(), "rb");
+
+            if (existing)
+            {
+                uint32_t header[2];
+                size_t read = fread(header, 1, sizeof(header), existing);
+                fclose(existing);
+
+                if (read != 0 && (read != sizeof(header) || header[0] != MAGIC || header[1] != VERSION))
+                {
+                    return false;
+                }
+            }
+
+            file = fopen(path.c_str(), "ab");
+
+            if (!file)
+            {
+                return false;
+            }
+
+            if (fseek(file, 0, SEEK_END) == 0 && ftell(file) == 0)
+            {
+                uint32_t header[2] = {MAGIC, VERSION};
+                fwrite(header, 1, sizeof(header), file);
+            }
+
+            dropped = 0;
+            queue.clear();
+            stopping = false;
+            thread = std::thread(&AnalyticsLog::run, this);
+
+            SessionRecord session = {};
+            session.startedAt = (int64_t)time(nullptr);
+            session.time = now;
+            session.worldSize = worldSize;
+            record(RecordType::Session, session);
+
+            return true;
+        }
+
+        // Write everything still queued and close the file
+        void stop()
+        {
+            if (!isRunning())
+            {
+                return;
+            }
+
+            stopping = true;
+            thread.join();
+
+            fclose(file);
+            file = nullptr;
+        }
+
+        // Queue a record to be written in the background
+        template <typename T>
+        void record(RecordType type, const T &data)
+        {
+            record(type, data, "", 0);
+        }
+
+        // Queue a record along with the variable length data that follows it
+        template <typename T>
+        void record(RecordType type, const T &data, const char* extra, size_t extraLength)
+        {
+            if (!isRunning())
+            {
+                return;
+            }
+
+            Entry entry;
+            extraLength = std::min(extraLength, sizeof(entry.payload) - sizeof(T));
+
+            entry.type = (uint8_t)type;
+            entry.size = (uint8_t)(sizeof(T) + extraLength);
+            memcpy(entry.payload, &data, sizeof(T));
+
+            if (extraLength > 0)
+            {
+                memcpy(entry.payload + sizeof(T), extra, extraLength);
+            }
+
+            if (!queue.push(entry))
+            {
+                dropped++;
+            }
+        }
+
+        // The number of records dropped because the queue was full since the last call
+        unsigned int takeDropped()
+        {
+            unsigned int count = dropped;
+            dropped = 0;
+
+            return count;
+        }
+
+    private:
+        static const uint32_t MAGIC = 0x4C414D55; // "UMAL"
+        static const uint32_t VERSION = 1;
+
+        struct Entry
+        {
+            uint8_t type;
+            uint8_t size;
+            char payload[MAX_RECORD_SIZE];
+        };
+
+        void run()
+        {
+            std::string buffer;
+            Entry entry;
+
+            while (true)
+            {
+                // Read the flag before draining so nothing queued before stop() was called is left behind
+                bool finishing = stopping;
+
+                while (queue.pop(entry))
+                {
+                    buffer.append((const char*)&entry, 2 + entry.size);
+                }
+
+                if (!buffer.empty())
+                {
+                    fwrite(buffer.data(), 1, buffer.size(), file);
+                    fflush(file);
+                    buffer.clear();
+                }
+
+                if (finishing)
+                {
+                    break;
+                }
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        }
+
+        SpscRing<Entry, 1024> queue;
+        std::thread thread;
+        std::atomic<bool> stopping;
+        FILE *file;
+        unsigned int dropped;
+    };
+
+    // A death or defusal message split up into literal text and placeholders when it's loaded, so announcing a kill only
+    // needs to copy each piece once
+    struct MessageTemplate
+    {
+        // The situation a message is written for, set with a [category=...] tag
+        enum class Category
+        {
+            Default,          // Any kill without a more specific message
+            Self,             // A player killed only by their own mine; death messages only
+            MultiKill,        // More than one player killed by the same explosion
+            Streak,           // A player whose mines have killed several players without them dying; death messages only
+            Count
+        };
+
+        enum class TokenType
+        {
+            Literal,          // Text copied as-is
+            Owner,            // %owner%
+            DefuserOrVictim,  // %victim% or %defuser%
+            MineCount,        // %minecount%
+            Victims,          // %victims%
+            VictimCount       // %victimcount%
+        };
+
+        struct Token
+        {
+            TokenType type;
+            size_t start;     // The position in `text` where a literal starts
+            size_t length;    // The length of a literal
+        };
+
+        std::string text;
+        std::vector<Token> tokens;
+        bool listsVictims = false; // True if the message uses %victims% or %victimcount%
+        Category category = Category::Default;
+        double weight = 1;         // How likely this message is to be picked compared to others in its category
+    };
+
+    // A small, fast random number generator (SplitMix64) so picking messages doesn't share the global rand() state with
+    // the server and other plug-ins
+    class Random
+    {
+    public:
+        Random() :
+            state(0)
+        {
+        }
+
+        void seed(uint64_t value)
+        {
+            state = value;
+        }
+
+        uint64_t next()
+        {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+            return z ^ (z >> 31);
+        }
+
+    private:
+        uint64_t state;
+    };
+
+    // Walker's alias method for picking from a weighted list in constant time. Every column holds its own item with some
+    // probability and one other item otherwise, so a pick is a single column lookup and one comparison.
+    class AliasTable
+    {
+    public:
+        void build(const std::vector<double> &weights)
+        {
+            size_t count = weights.size();
+            double total = 0;
+
+            // A column holding its own item for every coin flip has a threshold of 2^32
+            thresholds.assign(count, 0x100000000ULL);
+            aliases.resize(count);
+
+            for (size_t i = 0; i < count; i++)
+            {
+                total += weights[i];
+                aliases[i] = (uint32_t)i;
+            }
+
+            if (count == 0 || total <= 0)
+            {
+                return;
+            }
+
+            std::vector<double> scaled(count);
+            std::vector<uint32_t> small, large;
+
+            for (size_t i = 0; i < count; i++)
+            {
+                scaled[i] = weights[i] * count / total;
+                (scaled[i] < 1 ? small : large).push_back((uint32_t)i);
+            }
+
+            while (!small.empty() && !large.empty())
+            {
+                uint32_t less = small.back();
+                uint32_t more = large.back();
+                small.pop_back();
+
+                thresholds[less] = (uint64_t)(scaled[less] * 4294967296.0);
+                aliases[less] = more;
+
+                scaled[more] -= 1 - scaled[less];
+
+                if (scaled[more] < 1)
+                {
+                    large.pop_back();
+                    small.push_back(more);
+                }
+            }
+
+            // Whatever is left over is only due to rounding and keeps its whole column
+        }
+
+        bool empty() const
+        {
+            return thresholds.empty();
+        }
+
+        // Pick an item using 64 random bits: the high half chooses the column and the low half flips the biased coin
+        uint32_t pick(uint64_t random) const
+        {
+            uint32_t column = (uint32_t)(((random >> 32) * thresholds.size()) >> 32);
+
+            return ((random & 0xFFFFFFFFULL) < thresholds[column]) ? column : aliases[column];
+        }
+
+    private:
+        std::vector<uint64_t> thresholds; // The chance, out of 2^32, of a column picking its own item
+        std::vector<uint32_t> aliases;
+    };
+
+    // The messages loaded from a death or defusal message file, grouped by category with a weighted alias table for each
+    struct MessageSet
+    {
+        std::vector<MessageTemplate> templates;
+        std::vector<uint32_t> members[(int)MessageTemplate::Category::Count]; // The templates in each category
+        AliasTable tables[(int)MessageTemplate::Category::Count];
+
+        size_t size() const
+        {
+            return templates.size();
+        }
+
+        bool empty() const
+        {
+            return templates.empty();
+        }
+
+        void buildTables()
+        {
+            for (int category = 0; category < (int)MessageTemplate::Category::Count; category++)
+            {
+                std::vector<double> weights;
+                members[category].clear();
+
+                for (size_t i = 0; i < templates.size(); i++)
+                {
+                    if ((int)templates[i].category == category)
+                    {
+                        members[category].push_back((uint32_t)i);
+                        weights.push_back(templates[i].weight);
+                    }
+                }
+
+                tables[category].build(weights);
+            }
+        }
+
+        // Pick a random message from a category, optionally falling back to the default category when the category has
+        // no messages; returns nullptr if there's nothing to pick from
+        const MessageTemplate* pick(MessageTemplate::Category category, Random &random, bool fallback = true) const
+        {
+            if (tables[(int)category].empty())
+            {
+                if (!fallback || category == MessageTemplate::Category::Default)
+                {
+                    return nullptr;
+                }
+
+                category = MessageTemplate::Category::Default;
+
+                if (tables[(int)category].empty())
+                {
+                    return nullptr;
+                }
+            }
+
+            const std::vector<uint32_t> &pool = members[(int)category];
+
+            return &templates[pool[tables[(int)category].pick(random.next())]];
+        }
+    };
+
+    // The players killed by a single mine explosion, collected as their death events arrive so everyone killed by the
+    // same shot is announced in one message once the shot has ended
+    struct KillAnnouncement
+    {
+        uint32_t shotGUID;
+        ExplosionType type;
+        int shotOwnerID;
+        int mineOwnerID;
+        bool ownerKilled;                       // True if the mine owner was one of the victims
+        std::vector<int> victimIDs;             // The victims other than the mine owner
+        double sendBy;                          // The latest time to announce the kills if the shot hasn't ended
+    };
+
+    // The mine explosions that are still in flight, keyed by their shot GUID so a death can be matched to the mine that
+    // caused it with a single integer lookup instead of string-keyed shot metadata. This is an open addressing hash with
+    // linear probing; an entry is removed when its shot ends.
+    class ExplosionTable
+    {
+    public:
+        struct Explosion
+        {
+            uint32_t shotGUID;
+            ExplosionType type;
+            int shotOwnerID;        // The mine owner for a detonation or the defuser for a defusal
+            int mineOwnerID;
+            double firedAt;
+            bool used;
+        };
+
+        ExplosionTable() :
+            count(0)
+        {
+            slots.resize(16);
+        }
+
+        bool empty() const
+        {
+            return count == 0;
+        }
+
+        void add(uint32_t shotGUID, ExplosionType type, int shotOwnerID, int mineOwnerID, double now)
+        {
+            // Keep at most half of the slots in use so probe sequences stay short
+            if ((count + 1) * 2 > slots.size())
+            {
+                grow();
+            }
+
+            size_t slot = find(shotGUID);
+
+            if (!slots[slot].used)
+            {
+                count++;
+            }
+
+            slots[slot] = {shotGUID, type, shotOwnerID, mineOwnerID, now, true};
+        }
+
+        // Get the explosion a shot belongs to, or nullptr if the shot isn't one of this plug-in's explosions
+        const Explosion* get(uint32_t shotGUID) const
+        {
+            const Explosion &explosion = slots[find(shotGUID)];
+
+            return explosion.used ? &explosion : nullptr;
+        }
+
+        void remove(uint32_t shotGUID)
+        {
+            size_t slot = find(shotGUID);
+
+            if (!slots[slot].used)
+            {
+                return;
+            }
+
+            erase(slot);
+        }
+
+        // Forget explosions whose shot ended without the server telling us, such as shots still in flight when the
+        // plug-in was reloaded
+        void expire(double before)
+        {
+            for (size_t slot = 0; slot < slots.size(); )
+            {
+                // Erasing shifts a later entry into this slot, so only move on once the slot holds something else
+                if (slots[slot].used && slots[slot].firedAt < before)
+                {
+                    erase(slot);
+                }
+                else
+                {
+                    slot++;
+                }
+            }
+        }
+
+    private:
+        size_t find(uint32_t shotGUID) const
+        {
+            size_t mask = slots.size() - 1;
+            size_t slot = (shotGUID * 2654435761u) & mask;
+
+            while (slots[slot].used && slots[slot].shotGUID != shotGUID)
+            {
+                slot = (slot + 1) & mask;
+            }
+
+            return slot;
+        }
+
+        // Remove the entry in a slot, moving back any entries after it that would otherwise no longer be found
+        void erase(size_t slot)
+        {
+            size_t mask = slots.size() - 1;
+
+            slots[slot].used = false;
+            count--;
+
+            for (size_t next = (slot + 1) & mask; slots[next].used; next = (next + 1) & mask)
+            {
+                size_t home = (slots[next].shotGUID * 2654435761u) & mask;
+
+                // Move the entry back if the empty slot lies between its home slot and where it's stored
+                if (((next - home) & mask) >= ((next - slot) & mask))
+                {
+                    slots[slot] = slots[next];
+                    slots[next].used = false;
+                    slot = next;
+                }
+            }
+        }
+
+        void grow()
+        {
+            std::vector<Explosion> old(slots.size() * 2);
+            old.swap(slots);
+            count = 0;
+
+            for (const Explosion &explosion : old)
+            {
+                if (explosion.used)
+                {
+                    slots[find(explosion.shotGUID)] = explosion;
+                    count++;
+                }
+            }
+        }
+
+        std::vector<Explosion> slots;  // Always a power of two in size
+        size_t count;
+    };
+
+    // The callsign of every player on the server, filled in when they join and cleared when they leave, so announcing a
+    // kill or listing mine owners doesn't have to ask the server for callsigns
+    class CallsignTable
+    {
+    public:
+        static const int MAX_PLAYERS = 256;
+
+        void set(int playerID, const char* callsign)
+        {
+            if (playerID >= 0 && playerID < MAX_PLAYERS)
+            {
+                callsigns[playerID] = callsign ? callsign : "";
+            }
+        }
+
+        void clear(int playerID)
+        {
+            if (playerID >= 0 && playerID < MAX_PLAYERS)
+            {
+                callsigns[playerID].clear();
+            }
+        }
+
+        // Get a player's callsign, or nullptr if nobody is using the slot; the pointer stays valid until the player leaves
+        const char* get(int playerID) const
+        {
+            if (playerID < 0 || playerID >= MAX_PLAYERS || callsigns[playerID].empty())
+            {
+                return nullptr;
+            }
+
+            return callsigns[playerID].c_str();
+        }
+
+    private:
+        std::string callsigns[MAX_PLAYERS];
+    };
+
+    typedef std::shared_ptr<const MessageSet> MessageCatalog;
+
+    // Loads the death and defusal message files on a background thread so reading them never stalls the server. A
+    // reload happens when it's requested with `/reload` or, on Linux, when a file changes on disk. Newly loaded
+    // catalogs are published with an atomic pointer swap and picked up the next time a message is sent.
+    class MessageLoader
+    {
+    public:
+        enum Catalog
+        {
+            DeathMessages = 0,
+            DefusalMessages,
+            CatalogCount
+        };
+
+        // A message for the server log and, if a player requested the reload, a reply for the player
+        struct Notice
+        {
+            int playerID;
+            int debugLevel;
+            std::string message;
+            std::string reply;
+        };
+
+        MessageLoader() :
+            stopping(false),
+            watchFD(-1)
+        {
+            for (int i = 0; i < CatalogCount; i++)
+            {
+                catalogs[i] = std::make_shared<const MessageSet>();
+                requestedBy[i] = NO_REQUEST;
+            }
+        }
+
+        ~MessageLoader()
+        {
+            stop();
+        }
+
+        void setFile(Catalog catalog, const std::string &path)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            files[catalog] = path;
+        }
+
+        MessageCatalog get(Catalog catalog) const
+        {
+            return std::atomic_load(&catalogs[catalog]);
+        }
+
+        // Load a catalog on the calling thread
+        void load(Catalog catalog)
+        {
+            std::string path;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                path = files[catalog];
+            }
+
+            std::vector<std::string> warnings;
+            auto messages = std::make_shared<MessageSet>();
+
+            if (!path.empty())
+            {
+                loadMessageTemplates(path, messages->templates, warnings);
+            }
+
+            messages->buildTables();
+            std::atomic_store(&catalogs[catalog], MessageCatalog(messages));
+
+            std::lock_guard<std::mutex> lock(mutex);
+
+            for (std::string &warning : warnings)
+            {
+                notices.push_back({BZ_SERVER, 2, warning, ""});
+            }
+        }
+
+        void requestReload(Catalog catalog, int playerID)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                requestedBy[catalog] = playerID;
+            }
+
+            signal.notify_one();
+        }
+
+        void start()
+        {
+            if (thread.joinable())
+            {
+                return;
+            }
+
+            stopping = false;
+            watchFiles();
+            thread = std::thread(&MessageLoader::run, this);
+        }
+
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+
+            signal.notify_one();
+
+            if (thread.joinable())
+            {
+                thread.join();
+            }
+
+#ifdef __linux__
+            if (watchFD >= 0)
+            {
+                close(watchFD);
+                watchFD = -1;
+            }
+#endif
+        }
+
+        void takeNotices(std::vector<Notice> &out)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            out.swap(notices);
+        }
+
+    private:
+        static const int NO_REQUEST = -100;
+
+        void run()
+        {
+            while (true)
+            {
+                int reloadFor[CatalogCount];
+
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+
+                    // Wake up every so often to check for file changes if nothing is requested sooner
+                    signal.wait_for(lock, std::chrono::milliseconds(250), [this]() {
+                        return stopping || requestedBy[DeathMessages] != NO_REQUEST || requestedBy[DefusalMessages] != NO_REQUEST;
+                    });
+
+                    if (stopping)
+                    {
+                        return;
+                    }
+
+                    for (int i = 0; i < CatalogCount; i++)
+                    {
+                        reloadFor[i] = requestedBy[i];
+                        requestedBy[i] = NO_REQUEST;
+                    }
+                }
+
+                readFileChanges(reloadFor);
+
+                for (int i = 0; i < CatalogCount; i++)
+                {
+                    if (reloadFor[i] == NO_REQUEST)
+                    {
+                        continue;
+                    }
+
+                    load((Catalog)i);
+
+                    char message[128], reply[64];
+                    snprintf(message, sizeof(message), "DEBUG :: Useless Mine :: %d witty %s were reloaded",
+                             (int)get((Catalog)i)->size(), catalogName((Catalog)i));
+                    snprintf(reply, sizeof(reply), "%s reloaded", (i == DeathMessages) ? "Death messages" : "Defusal messages");
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    notices.push_back({reloadFor[i], 2, message, reply});
+                }
+            }
+        }
+
+        static const char* catalogName(Catalog catalog)
+        {
+            return (catalog == DeathMessages) ? "death messages" : "defusal messages";
+        }
+
+        // Split a path into its directory and file name
+        static void splitPath(const std::string &path, std::string &directory, std::string &fileName)
+        {
+            size_t slash = path.find_last_of("/\\");
+
+            directory = (slash == std::string::npos) ? "." : path.substr(0, slash + 1);
+            fileName  = (slash == std::string::npos) ? path : path.substr(slash + 1);
+        }
+
+        // Watch the directories of the message files since editors often replace a file instead of writing to it
+        void watchFiles()
+        {
+#ifdef __linux__
+            watchFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+            if (watchFD < 0)
+            {
+                return;
+            }
+
+            for (int i = 0; i < CatalogCount; i++)
+            {
+                watchDescriptors[i] = -1;
+
+                if (files[i].empty())
+                {
+                    continue;
+                }
+
+                std::string directory;
+                splitPath(files[i], directory, watchedNames[i]);
+                watchDescriptors[i] = inotify_add_watch(watchFD, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+            }
+#endif
+        }
+
+        // Mark the catalogs whose files changed on disk as needing a reload
+        void readFileChanges(int reloadFor[CatalogCount])
+        {
+#ifdef __linux__
+            if (watchFD < 0)
+            {
+                return;
+            }
+
+            char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+            ssize_t length;
+
+            while ((length = read(watchFD, buffer, sizeof(buffer))) > 0)
+            {
+                for (char *ptr = buffer; ptr < buffer + length; ptr += sizeof(struct inotify_event) + ((struct inotify_event*)ptr)->len)
+                {
+                    const struct inotify_event *event = (const struct inotify_event*)ptr;
+
+                    for (int i = 0; i < CatalogCount; i++)
+                    {
+                        if (event->wd == watchDescriptors[i] && event->len > 0 && watchedNames[i] == event->name && reloadFor[i] == NO_REQUEST)
+                        {
+                            reloadFor[i] = BZ_SERVER;
+                        }
+                    }
+                }
+            }
+#else
+            (void)reloadFor;
+#endif
+        }
+
+        std::string files[CatalogCount];
+        MessageCatalog catalogs[CatalogCount];
+
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable signal;
+        bool stopping;
+        int requestedBy[CatalogCount];    // The player who requested a reload of each catalog, or NO_REQUEST
+        std::vector<Notice> notices;
+
+        int watchFD;
+        int watchDescriptors[CatalogCount];
+        std::string watchedNames[CatalogCount];
+    };
+
+    enum class TraceType
+    {
+        Placed,         // A mine was placed
+        Removed,        // A mine was removed from the field
+        InRange,        // A player was found inside of a mine's trigger
+        Detonated,      // A mine was detonated by a player
+        Defused,        // A mine was defused by a player
+        Ignored         // A player triggered a mine but it couldn't be detonated or defused
+    };
+
+    // A fixed-size log of the most recent mine decisions, kept in memory so they can be dumped by an admin after an odd
+    // detonation without having to run the server at a verbose debug level
+    class TraceLog
+    {
+    public:
+        struct Entry
+        {
+            double time;
+            TraceType type;
+            int playerID;
+            unsigned int mineID;
+            float pos[3];
+        };
+
+        static const unsigned int CAPACITY = 256;
+
+        TraceLog() :
+            next(0),
+            count(0)
+        {
+        }
+
+        void record(TraceType type, int playerID, unsigned int mineID, const float pos[3])
+        {
+            Entry &entry = entries[next];
+            entry.time = bz_getCurrentTime();
+            entry.type = type;
+            entry.playerID = playerID;
+            entry.mineID = mineID;
+            entry.pos[0] = pos[0];
+            entry.pos[1] = pos[1];
+            entry.pos[2] = pos[2];
+
+            next = (next + 1) % CAPACITY;
+
+            if (count < CAPACITY)
+            {
+                count++;
+            }
+        }
+
+        unsigned int size() const
+        {
+            return count;
+        }
+
+        // Get an entry with 0 being the oldest entry still in the log
+        const Entry& get(unsigned int i) const
+        {
+            return entries[(next + CAPACITY - count + i) % CAPACITY];
+        }
+
+        static const char* typeName(TraceType type)
+        {
+            switch (type)
+            {
+                case TraceType::Placed:    return "placed";
+                case TraceType::Removed:   return "removed";
+                case TraceType::InRange:   return "in range";
+                case TraceType::Detonated: return "detonated";
+                case TraceType::Defused:   return "defused";
+                case TraceType::Ignored:   return "ignored";
+            }
+
+            return "unknown";
+        }
+
+    private:
+        Entry entries[CAPACITY];
+        unsigned int next;
+        unsigned int count;
+    };
+
+    // Latency histograms for each event the plug-in handles along with counters for the work done checking mines. Each
+    // histogram has a bucket per power of two nanoseconds, so recording a sample is a couple of instructions and the
+    // percentiles are accurate to within a factor of two.
+    class PerfStats
+    {
+    public:
+        enum class Section
+        {
+            BZDBChange,
+            FlagDropped,
+            FlagGrabbed,
+            FlagTransferred,
+            PlayerDie,
+            PlayerJoin,
+            PlayerPart,
+            PlayerSpawn,
+            PlayerUpdate,
+            Tick,
+            WorldFinalized,
+            SlashCommand,
+            Other,
+            Count
+        };
+
+        enum class Counter
+        {
+            UpdatesChecked,   // Player positions checked against the mine field
+            UpdatesSlept,     // Player positions skipped because the player was too far from any mine to reach one
+            MinesScanned,     // Mines in the grid cells around those positions
+            CandidateHits,    // Mines that passed the proximity filter
+            MinesInRange,     // Mines whose trigger box the player actually touched
+            ClearanceScans,   // Checks that measured how far the player was from the closest mine
+            ClearanceCells,   // Grid cells looked up while measuring those distances
+            Detonations,      // Mines that blew up or were defused
+            BufferGrowths,    // Times a scratch buffer had to allocate more memory
+            Count
+        };
+
+        static const int BUCKETS = 40;
+
+        struct Histogram
+        {
+            unsigned long long calls;
+            unsigned long long totalNs;
+            unsigned long long maxNs;
+            unsigned long long buckets[BUCKETS];
+
+            // Estimate a percentile as the upper edge of the bucket it falls in
+            unsigned long long percentile(double fraction) const
+            {
+                unsigned long long target = (unsigned long long)std::ceil(calls * fraction), seen = 0;
+
+                for (int i = 0; i < BUCKETS; i++)
+                {
+                    seen += buckets[i];
+
+                    if (seen >= target && seen > 0)
+                    {
+                        return std::min(maxNs, (2ULL << i) - 1);
+                    }
+                }
+
+                return maxNs;
+            }
+        };
+
+        // Times the enclosing block and records it against a section
+        class Scope
+        {
+        public:
+            Scope(PerfStats &_stats, Section _section) :
+                stats(_stats),
+                section(_section),
+                start(std::chrono::steady_clock::now())
+            {
+            }
+
+            ~Scope()
+            {
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                stats.record(section, (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+            }
+
+        private:
+            PerfStats &stats;
+            Section section;
+            std::chrono::steady_clock::time_point start;
+        };
+
+        PerfStats()
+        {
+            memset(histograms, 0, sizeof(histograms));
+            memset(counters, 0, sizeof(counters));
+            since = 0;
+        }
+
+        void reset()
+        {
+            memset(histograms, 0, sizeof(histograms));
+            memset(counters, 0, sizeof(counters));
+            since = bz_getCurrentTime();
+        }
+
+        void record(Section section, unsigned long long ns)
+        {
+            Histogram &histogram = histograms[(int)section];
+            int bucket = 0;
+
+            for (unsigned long long value = ns >> 1; value && bucket < BUCKETS - 1; value >>= 1)
+            {
+                bucket++;
+            }
+
+            histogram.calls++;
+            histogram.totalNs += ns;
+            histogram.maxNs = std::max(histogram.maxNs, ns);
+            histogram.buckets[bucket]++;
+        }
+
+        const Histogram& get(Section section) const
+        {
+            return histograms[(int)section];
+        }
+
+        static Section sectionFor(bz_eEventType eventType)
+        {
+            switch (eventType)
+            {
+                case bz_eBZDBChange:          return Section::BZDBChange;
+                case bz_eFlagDroppedEvent:    return Section::FlagDropped;
+                case bz_eFlagGrabbedEvent:    return Section::FlagGrabbed;
+                case bz_eFlagTransferredEvent: return Section::FlagTransferred;
+                case bz_ePlayerDieEvent:      return Section::PlayerDie;
+                case bz_ePlayerJoinEvent:     return Section::PlayerJoin;
+                case bz_ePlayerPartEvent:     return Section::PlayerPart;
+                case bz_ePlayerSpawnEvent:    return Section::PlayerSpawn;
+                case bz_ePlayerUpdateEvent:   return Section::PlayerUpdate;
+                case bz_eTickEvent:           return Section::Tick;
+                case bz_eWorldFinalized:      return Section::WorldFinalized;
+                default:                      return Section::Other;
+            }
+        }
+
+        static const char* sectionName(Section section)
+        {
+            static const char* names[] = {
+                "BZDB change", "flag dropped", "flag grabbed", "flag transferred", "player die", "player join",
+                "player part", "player spawn", "player update", "tick", "world finalized", "slash command", "other"
+            };
+
+            return names[(int)section];
+        }
+
+        static const char* counterName(Counter counter)
+        {
+            static const char* names[] = {
+                "updates checked", "updates slept", "mines scanned", "candidate hits", "mines in range", "clearance scans",
+                "clearance cells", "detonations", "buffer growths"
+            };
+
+            return names[(int)counter];
+        }
+
+        unsigned long long counters[(int)Counter::Count];
+        double since; // The time the statistics were last reset
+
+    private:
+        Histogram histograms[(int)Section::Count];
+    };
+
+private:
+    int getMineCount();
+
+    void loadConfiguration(const char* commandline);
+    void sendMessageLoaderNotices();
+    void loadPlayerStates();
+    void refreshSettings();
+    void removePlayerMines(int playerID);
+    void removeExpiredMines();
+    void rescheduleMineExpiry();
+    void saveMineSnapshot();
+    void startAnalytics();
+    void recordPlayer(int playerID);
+    void recordMineRemoved(MineHandle mine, AnalyticsLog::RemoveReason reason);
+    void recordMineTriggered(AnalyticsLog::RecordType type, MineHandle mine, uint32_t shotGUID, int triggeredBy);
+    void restoreMineSnapshot();
+    void removeMine(MineHandle mine);
+    void checkForTriggeredMines(int playerID, const float from[3], const float to[3]);
+    void scheduleNextCheck(int playerID, const float pos[3], bool minesNearby);
+    void checkPendingPlayers();
+    void handlePlayerPosition(int playerID, const float pos[3]);
+    void rebuildMineGrid(double cellSize);
+    bool triggerMine(int playerID, MineHandle mine, const float pos[3]);
+    void startTriggerWorker();
+    void stopTriggerWorker();
+    void sendWorkerConfiguration();
+    void sendWorkerMine(TriggerWorker::Command::Type type, MineHandle mine);
+    void processWorkerHits();
+    void queueKillAnnouncement(uint32_t shotGUID, ExplosionType type, int shotOwnerID, int mineOwnerID, int victimID);
+    void sendKillAnnouncements(bool waitForShots);
+    void sendDefuseMessage(const KillAnnouncement &kill);
+    void sendDeathMessage(const KillAnnouncement &kill);
+    void setMine(int owner, float pos[3], bz_eTeamType team);
+
+    bool defuseMine(MineHandle mine, int defuserID);
+    bool detonateMine(MineHandle mine, int triggeredBy);
+    void sendTraceLog(int playerID);
+    void sendPerfStats(int playerID);
+    void writePerfLog();
+    void formatPerfStats(std::vector<std::string> &lines);
+
+    const std::string& formatMineMessage(const MessageTemplate &msg, const char* mineOwner, const char* defuserOrVictim,
+                                         const char* victims, int victimCount);
+    std::string parsePath(bz_ApiString path);
+
+    static const char* getTeamName(bz_eTeamType team);
+    const std::string& listCallsigns(int firstID, const std::vector<int> &playerIDs);
+
+    static void loadMessageTemplates(const std::string &file, std::vector<MessageTemplate> &templates, std::vector<std::string> &warnings);
+    static void parseMessageTags(MessageTemplate &message, const std::string &file, int lineNumber, std::vector<std::string> &warnings);
+
+    MessageLoader messageLoader; // Stores all of the witty death and defusal messages
+    std::string messageBuffer; // The buffer death and defusal messages are formatted into
+
+    MineStore activeMines; // All of the mines currently on the field
+    MineGrid mineGrid; // A spatial index of activeMines used to find the mines near a player
+    std::vector<GridEntry> nearbyMines; // Scratch space for mine grid queries
+    unsigned int nextMineSeq = 0; // The sequence number given to the next mine placed
+    std::string deathMessagesFile; // The path to the file containing death messages
+    std::string defusalMessagesFile; // The path to the file containing defusal messages
+    std::string snapshotFile; // The path to the file the mine field is kept in while the plug-in is reloaded
+    PlayerState playerStates[256]; // The state of each player slot, maintained through events
+    Settings settings; // Cached server settings used by the player update hot path
+    TraceLog traceLog; // The most recent mine decisions, available with `/minestats trace`
+    PerfStats perfStats; // Event timings and mine check counters, available with `/minestats perf`
+    double nextPerfLog = 0; // The time the performance statistics are next written to _minePerfLogFile
+
+    ExplosionTable explosions; // The mine explosions still in flight, used to blame deaths on the right players
+    AnalyticsLog analytics; // Mine activity written to _mineAnalyticsFile
+
+    unsigned int mineFieldVersion = 0; // Incremented whenever a mine is placed so players get checked against it
+    std::vector<int> pendingPlayers; // Players with a position waiting to be checked on the next tick
+    TimerWheel mineExpiry;           // When each mine reaches the end of its _mineLifetime
+    std::vector<MineHandle> expiredMines;
+    std::vector<KillAnnouncement> killAnnouncements; // Mine kills waiting for their explosion's shot to end
+    CallsignTable callsigns; // The callsign of every player on the server
+    Random random; // Used to pick death and defusal messages
+    std::string callsignList; // The buffer lists of victims are joined into
+    ProximityKernel proximityKernel = findNearbyMinesScalar; // The fastest mine filter this CPU supports
+    TriggerWorker triggerWorker; // Checks for triggered mines off the main thread when _mineWorkerThread is set
+    std::vector<TriggerWorker::Hit> workerHits; // Hits taken from the worker that haven't been acted on yet
+    bool processingWorkerHits = false; // True while workerHits is being acted on
+    long long triggeredWorkerCheck = -1; // The last worker check that set off a mine; its other hits may arrive later
+
+    const char* bzdb_safetyTime = "_mineSafetyTime";
+    const char* bzdb_checkInterval = "_mineCheckInterval";
+    const char* bzdb_checkDistance = "_mineCheckDistance";
+    const char* bzdb_tickChecks = "_mineTickChecks";
+    const char* bzdb_lifetime = "_mineLifetime";
+    const char* bzdb_maxPerPlayer = "_mineMaxPerPlayer";
+    const char* bzdb_maxTotal = "_mineMaxTotal";
+    const char* bzdb_perfLogFile = "_minePerfLogFile";
+    const char* bzdb_perfLogInterval = "_minePerfLogInterval";
+    const char* bzdb_workerThread = "_mineWorkerThread";
+    const char* bzdb_analyticsFile = "_mineAnalyticsFile";
+    const char* bzdb_shockOutRadius = "_shockOutRadius";
+    const char* bzdb_tankSpeed = "_tankSpeed";
+    const char* bzdb_velocityAd = "_velocityAd";
+    const char* bzdb_worldSize = "_worldSize";
+};
+
+BZ_PLUGIN(UselessMine)
+
+
+const char* UselessMine::Name(void)
+{
+    static std::string pluginName;
+
+    if (pluginName.empty())
+    {
+        pluginName = bz_format("%s %d.%d.%d (%d)", PLUGIN_NAME.c_str(), MAJOR, MINOR, REV, BUILD);
+    }
+
+    return pluginName.c_str();
+}
+
+void UselessMine::Init(const char* commandLine)
+{
+    Register(bz_eBZDBChange);
+    Register(bz_eFlagDroppedEvent);
+    Register(bz_eFlagGrabbedEvent);
+    Register(bz_eFlagTransferredEvent);
+    Register(bz_eNewRabbitEvent);
+    Register(bz_ePlayerDieEvent);
+    Register(bz_ePlayerJoinEvent);
+    Register(bz_ePlayerPartEvent);
+    Register(bz_ePlayerSpawnEvent);
+    Register(bz_ePlayerUpdateEvent);
+    Register(bz_eShotEndedEvent);
+    Register(bz_eTickEvent);
+    Register(bz_eWorldFinalized);
+
+    bz_registerCustomSlashCommand("mine", this);
+    bz_registerCustomSlashCommand("minecount", this);
+    bz_registerCustomSlashCommand("minestats", this);
+    bz_registerCustomSlashCommand("reload", this);
+
+    bz_RegisterCustomFlag("BD", "Bomb Defusal", "Safely defuse enemy mines while killing the mine owners", 0, eGoodFlag);
+
+    bz_registerCustomBZDBInt(bzdb_safetyTime, 5);
+    bz_registerCustomBZDBInt(bzdb_checkInterval, 1);
+    bz_registerCustomBZDBDouble(bzdb_checkDistance, 0);
+    bz_registerCustomBZDBBool(bzdb_tickChecks, false);
+    bz_registerCustomBZDBInt(bzdb_lifetime, 0);
+    bz_registerCustomBZDBInt(bzdb_maxPerPlayer, 0);
+    bz_registerCustomBZDBInt(bzdb_maxTotal, 0);
+    bz_registerCustomBZDBString(bzdb_perfLogFile, "");
+    bz_registerCustomBZDBInt(bzdb_perfLogInterval, 60);
+    bz_registerCustomBZDBBool(bzdb_workerThread, false);
+    bz_registerCustomBZDBString(bzdb_analyticsFile, "");
+
+    const char* kernelName;
+    proximityKernel = selectProximityKernel(kernelName);
+    mineGrid.setKernel(proximityKernel);
+    bz_debugMessagef(2, "DEBUG :: Useless Mine :: Using the %s mine proximity kernel", kernelName);
+
+    loadConfiguration(commandLine);
+    loadPlayerStates();
+    mineExpiry.reset(bz_getCurrentTime());
+    perfStats.reset();
+    random.seed((uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    refreshSettings();
+    restoreMineSnapshot();
+
+    messageLoader.load(MessageLoader::DeathMessages);
+    messageLoader.load(MessageLoader::DefusalMessages);
+    sendMessageLoaderNotices();
+
+    MessageCatalog deathMessages = messageLoader.get(MessageLoader::DeathMessages);
+    MessageCatalog defusalMessages = messageLoader.get(MessageLoader::DefusalMessages);
+
+    if (deathMessages->empty())
+    {
+        bz_debugMessage(2, "WARNING :: Useless Mine :: No witty death messages were loaded");
+    }
+    else
+    {
+        bz_debugMessagef(2, "DEBUG :: Useless Mine :: %d witty death messages were loaded", deathMessages->size());
+    }
+
+    if (defusalMessages->empty())
+    {
+        bz_debugMessage(2, "WARNING :: Useless Mine :: No witty defusal messages were loaded");
+    }
+    else
+    {
+        bz_debugMessagef(2, "DEBUG :: Useless Mine :: %d witty defusal messages were loaded", defusalMessages->size());
+    }
+
+    messageLoader.start();
+}
+
+void UselessMine::Cleanup(void)
+{
+    Flush();
+
+    stopTriggerWorker();
+    saveMineSnapshot();
+    analytics.stop();
+    messageLoader.stop();
+
+    bz_removeCustomSlashCommand("mine");
+    bz_removeCustomSlashCommand("minecount");
+    bz_removeCustomSlashCommand("minestats");
+    bz_removeCustomSlashCommand("reload");
+
+    bz_removeCustomBZDBVariable(bzdb_safetyTime);
+    bz_removeCustomBZDBVariable(bzdb_checkInterval);
+    bz_removeCustomBZDBVariable(bzdb_checkDistance);
+    bz_removeCustomBZDBVariable(bzdb_tickChecks);
+    bz_removeCustomBZDBVariable(bzdb_lifetime);
+    bz_removeCustomBZDBVariable(bzdb_maxPerPlayer);
+    bz_removeCustomBZDBVariable(bzdb_maxTotal);
+    bz_removeCustomBZDBVariable(bzdb_perfLogFile);
+    bz_removeCustomBZDBVariable(bzdb_perfLogInterval);
+    bz_removeCustomBZDBVariable(bzdb_workerThread);
+    bz_removeCustomBZDBVariable(bzdb_analyticsFile);
+}
+
+void UselessMine::Event(bz_EventData *eventData)
+{
+    PERF_SCOPE(PerfStats::sectionFor(eventData->eventType));
+
+    switch (eventData->eventType)
+    {
+        case bz_eBZDBChange:
+        {
+            bz_BZDBChangeData_V1* bzdbData = (bz_BZDBChangeData_V1*)eventData;
+
+            const char* settingsKeys[] = {
+                bzdb_safetyTime, bzdb_checkInterval, bzdb_checkDistance, bzdb_tickChecks, bzdb_lifetime, bzdb_maxPerPlayer,
+                bzdb_maxTotal, bzdb_perfLogFile, bzdb_perfLogInterval, bzdb_workerThread, bzdb_analyticsFile, bzdb_shockOutRadius, bzdb_tankSpeed,
+                bzdb_velocityAd
+            };
+
+            for (const char* key : settingsKeys)
+            {
+                if (bzdbData->key == key)
+                {
+                    refreshSettings();
+                    break;
+                }
+            }
+        }
+        break;
+
+        case bz_eFlagDroppedEvent:
+        {
+            bz_FlagDroppedEventData_V1* flagDropData = (bz_FlagDroppedEventData_V1*)eventData;
+
+            playerStates[flagDropData->playerID].hasDefusal = false;
+        }
+        break;
+
+        case bz_eFlagGrabbedEvent:
+        {
+            bz_FlagGrabbedEventData_V1* flagGrabData = (bz_FlagGrabbedEventData_V1*)eventData;
+
+            playerStates[flagGrabData->playerID].hasDefusal = (strcmp(flagGrabData->flagType, "BD") == 0);
+
+            // If the user grabbed the Useless flag, let them know they can place a mine
+            if (strcmp(flagGrabData->flagType, "US") == 0)
+            {
+                bz_sendTextMessage(BZ_SERVER, flagGrabData->playerID, "You grabbed a Useless flag! Type /mine at any time to set a useless mine!");
+            }
+        }
+        break;
+
+        case bz_eFlagTransferredEvent:
+        {
+            bz_FlagTransferredEventData_V1* flagTransferData = (bz_FlagTransferredEventData_V1*)eventData;
+
+            // A flag was stolen with Thief, so the thief now carries the stolen flag
+            playerStates[flagTransferData->fromPlayerID].hasDefusal = false;
+            playerStates[flagTransferData->toPlayerID].hasDefusal = (strcmp(flagTransferData->flagType, "BD") == 0);
+        }
+        break;
+
+        case bz_eNewRabbitEvent:
+        {
+            bz_NewRabbitEventData_V1* rabbitData = (bz_NewRabbitEventData_V1*)eventData;
+
+            // The new rabbit can be anointed while alive, so their team changes without a spawn. The old rabbit goes
+            // back to hunting. Both have to be measured against the mines of their new enemies before they're skipped.
+            for (int playerID = 0; playerID < 256; playerID++)
+            {
+                PlayerState &player = playerStates[playerID];
+
+                if (playerID == rabbitData->newRabbit || (player.connected && player.team == eRabbitTeam))
+                {
+                    player.team = (playerID == rabbitData->newRabbit) ? eRabbitTeam : eHunterTeam;
+                    player.clearance = 0;
+                    player.sleepUntil = 0;
+                }
+            }
+        }
+        break;
+
+        case bz_ePlayerDieEvent:
+        {
+            bz_PlayerDieEventData_V1* dieData = (bz_PlayerDieEventData_V1*)eventData;
+
+            int victimID = dieData->playerID;
+            playerStates[victimID].spawned = false;
+            playerStates[victimID].hasPendingPos = false;
+            playerStates[victimID].mineKills = 0;
+
+            // Only handle shots that are one of this plugin's explosions
+            if (explosions.empty())
+            {
+                break;
+            }
+
+            uint32_t shotGUID = bz_getShotGUID(dieData->killerID, dieData->shotID);
+            const ExplosionTable::Explosion* explosion = explosions.get(shotGUID);
+
+            if (explosion)
+            {
+                int shotOwnerID = explosion->shotOwnerID;
+                int mineOwnerID = explosion->mineOwnerID;
+
+                // Reassign the killer ID to the mine owner or the bomb defuser
+                dieData->killerID = shotOwnerID;
+
+                if (explosion->type == ExplosionType::Mine && victimID != mineOwnerID && mineOwnerID >= 0 && mineOwnerID < 256)
+                {
+                    playerStates[mineOwnerID].mineKills++;
+                }
+
+                queueKillAnnouncement(shotGUID, explosion->type, shotOwnerID, mineOwnerID, victimID);
+            }
+        }
+        break;
+
+        case bz_ePlayerJoinEvent:
+        {
+            bz_PlayerJoinPartEventData_V1* joinData = (bz_PlayerJoinPartEventData_V1*)eventData;
+
+            PlayerState &player = playerStates[joinData->playerID];
+            player = PlayerState();
+            player.connected = true;
+            player.team = joinData->record->team;
+
+            callsigns.set(joinData->playerID, joinData->record->callsign.c_str());
+            recordPlayer(joinData->playerID);
+        }
+        break;
+
+        case bz_ePlayerPartEvent:
+        {
+            bz_PlayerJoinPartEventData_V1* partData = (bz_PlayerJoinPartEventData_V1*)eventData;
+
+            int playerID = partData->playerID;
+
+            // Remove all the mines belonging to the player who just left
+            removePlayerMines(playerID);
+            playerStates[playerID] = PlayerState();
+
+            // Announce any kills the player was part of while their callsign is still known
+            sendKillAnnouncements(false);
+            callsigns.clear(playerID);
+        }
+        break;
+
+        case bz_ePlayerSpawnEvent:
+        {
+            bz_PlayerSpawnEventData_V1* spawnData = (bz_PlayerSpawnEventData_V1*)eventData;
+
+            PlayerState &player = playerStates[spawnData->playerID];
+
+            // Save the time the player spawned last; apart from becoming the rabbit, a player can only switch teams
+            // while dead so this is also where a team change is picked up
+            player.spawned = true;
+            player.hasDefusal = false;
+            player.team = spawnData->team;
+            player.spawnTime = bz_getCurrentTime();
+            player.hasCheckedPos = false;
+            player.hasPendingPos = false;
+            player.clearance = 0;
+            player.sleepUntil = 0;
+        }
+        break;
+
+        case bz_ePlayerUpdateEvent:
+        {
+            bz_PlayerUpdateEventData_V1* updateData = (bz_PlayerUpdateEventData_V1*)eventData;
+
+            int playerID = updateData->playerID;
+            const float *pos = updateData->state.pos;
+
+            TRACE_MESSAGE("DEBUG :: Useless Mine :: player #%d at {%0.2f, %0.2f, %0.2f}", playerID, pos[0], pos[1], pos[2]);
+
+            if (settings.tickChecks)
+            {
+                // Only remember the latest position; all of the players who moved are checked at once on the next tick
+                PlayerState &player = playerStates[playerID];
+
+                if (!player.hasPendingPos)
+                {
+                    size_t capacity = pendingPlayers.capacity();
+
+                    player.hasPendingPos = true;
+                    pendingPlayers.push_back(playerID);
+
+                    PERF_BUFFER(pendingPlayers, capacity);
+                }
+
+                player.pendingPos[0] = pos[0];
+                player.pendingPos[1] = pos[1];
+                player.pendingPos[2] = pos[2];
+
+                break;
+            }
+
+            handlePlayerPosition(playerID, pos);
+        }
+        break;
+
+        case bz_eShotEndedEvent:
+        {
+            bz_ShotEndedEventData_V1* shotData = (bz_ShotEndedEventData_V1*)eventData;
+
+            if (!explosions.empty())
+            {
+                explosions.remove(bz_getShotGUID(shotData->playerID, shotData->shotID));
+            }
+        }
+        break;
+
+        case bz_eTickEvent:
+        {
+            removeExpiredMines();
+            checkPendingPlayers();
+            processWorkerHits();
+            sendKillAnnouncements(true);
+            sendMessageLoaderNotices();
+
+            if (!explosions.empty())
+            {
+                explosions.expire(bz_getCurrentTime() - EXPLOSION_TIMEOUT);
+            }
+
+            if (unsigned int dropped = analytics.takeDropped())
+            {
+                bz_debugMessagef(2, "WARNING :: Useless Mine :: %u analytics records were dropped because the log couldn't keep up", dropped);
+            }
+
+            if (!settings.perfLogFile.empty() && bz_getCurrentTime() >= nextPerfLog)
+            {
+                writePerfLog();
+                nextPerfLog = bz_getCurrentTime() + settings.perfLogInterval;
+            }
+        }
+        break;
+
+        case bz_eWorldFinalized:
+        {
+            refreshSettings();
+        }
+        break;
+
+        default:
+            break;
+    }
+}
+
+bool UselessMine::SlashCommand(int playerID, bz_ApiString command, bz_ApiString /*message*/, bz_APIStringList *params)
+{
+    PERF_SCOPE(PerfStats::Section::SlashCommand);
+
+    if (command == "mine")
+    {
+        bz_BasePlayerRecord *pr = bz_getPlayerByIndex(playerID);
+
+        if (pr->team != eObservers)
+        {
+            // Check if the player has the Useless flag
+            if (pr->currentFlag == "USeless (+US)")
+            {
+                // Store their current position
+                float currentPosition[3] = {pr->lastKnownState.pos[0], pr->lastKnownState.pos[1], pr->lastKnownState.pos[2]};
+
+                setMine(playerID, currentPosition, pr->team);
+            }
+            else
+            {
+                bz_sendTextMessage(BZ_SERVER, playerID, "You can't place a mine without the Useless flag!");
+            }
+        }
+        else
+        {
+            bz_sendTextMessage(BZ_SERVER, playerID, "Silly observer, you can't place a mine.");
+        }
+
+        bz_freePlayerRecord(pr);
+
+        return true;
+    }
+    else if (command == "minecount")
+    {
+        bz_sendTextMessagef(BZ_SERVER, playerID, "There are currently %d active mines on the field", getMineCount());
+
+        if (settings.gameType != eOpenFFAGame)
+        {
+            for (int team = eRogueTeam; team < MineStore::MAX_TEAMS; team++)
+            {
+                int teamMines = activeMines.countForTeam((bz_eTeamType)team);
+
+                if (teamMines > 0)
+                {
+                    bz_sendTextMessagef(BZ_SERVER, playerID, "  %-16s %d", getTeamName((bz_eTeamType)team), teamMines);
+                }
+            }
+        }
+
+        return true;
+    }
+    else if (command == "minestats")
+    {
+        if (params->size() > 0 && params->get(0) == "trace")
+        {
+            if (!bz_hasPerm(playerID, "setAll"))
+            {
+                bz_sendTextMessage(BZ_SERVER, playerID, "You do not have permission to view the mine trace log.");
+                return true;
+            }
+
+            sendTraceLog(playerID);
+
+            return true;
+        }
+        else if (params->size() > 0 && params->get(0) == "perf")
+        {
+            if (!bz_hasPerm(playerID, "setAll"))
+            {
+                bz_sendTextMessage(BZ_SERVER, playerID, "You do not have permission to view the mine performance statistics.");
+                return true;
+            }
+
+            if (params->size() > 1 && params->get(1) == "reset")
+            {
+                perfStats.reset();
+                bz_sendTextMessage(BZ_SERVER, playerID, "Mine performance statistics reset");
+
+                return true;
+            }
+
+            sendPerfStats(playerID);
+
+            return true;
+        }
+
+        bz_sendTextMessagef(BZ_SERVER, playerID, "Player Mines");
+        bz_sendTextMessagef(BZ_SERVER, playerID, "------------");
+
+        // Sort the players with mines by their mine count, breaking ties by callsign
+        int owners[MineStore::MAX_PLAYERS];
+        int ownerTotal = 0;
+
+        for (int owner = 0; owner < MineStore::MAX_PLAYERS; owner++)
+        {
+            if (activeMines.countForOwner(owner) > 0 && callsigns.get(owner))
+            {
+                owners[ownerTotal++] = owner;
+            }
+        }
+
+        std::sort(owners, owners + ownerTotal, [this](int a, int b) {
+            int countA = activeMines.countForOwner(a), countB = activeMines.countForOwner(b);
+
+            return (countA != countB) ? (countA > countB) : (strcmp(callsigns.get(a), callsigns.get(b)) < 0);
+        });
+
+        for (int i = 0; i < ownerTotal; i++)
+        {
+            bz_sendTextMessagef(BZ_SERVER, playerID, "%-32s %d", callsigns.get(owners[i]), activeMines.countForOwner(owners[i]));
+        }
+
+        return true;
+    }
+    else if (command == "reload" && bz_hasPerm(playerID, "setAll"))
+    {
+        if (params->size() == 0)
+        {
+            messageLoader.requestReload(MessageLoader::DeathMessages, BZ_SERVER);
+            messageLoader.requestReload(MessageLoader::DefusalMessages, BZ_SERVER);
+        }
+
+        else if (params->get(0) == "deathmessages")
+        {
+            messageLoader.requestReload(MessageLoader::DeathMessages, playerID);
+            return true;
+        }
+
+        else if (params->get(0) == "defusalmessages")
+        {
+            messageLoader.requestReload(MessageLoader::DefusalMessages, playerID);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// A function to format death messages in order to replace placeholders with callsigns and values
+const std::string& UselessMine::formatMineMessage(const MessageTemplate &msg, const char* mineOwner, const char* defuserOrVictim,
+                                                   const char* victims, int victimCount)
+{
+    size_t capacity = messageBuffer.capacity();
+    messageBuffer.clear();
+
+    for (const MessageTemplate::Token &token : msg.tokens)
+    {
+        switch (token.type)
+        {
+            case MessageTemplate::TokenType::Literal:
+                messageBuffer.append(msg.text, token.start, token.length);
+                break;
+
+            case MessageTemplate::TokenType::Owner:
+                messageBuffer.append(mineOwner);
+                break;
+
+            case MessageTemplate::TokenType::DefuserOrVictim:
+                messageBuffer.append(defuserOrVictim);
+                break;
+
+            case MessageTemplate::TokenType::MineCount:
+            {
+                char count[16];
+                snprintf(count, sizeof(count), "%d", getMineCount());
+                messageBuffer.append(count);
+            }
+            break;
+
+            case MessageTemplate::TokenType::Victims:
+                messageBuffer.append(victims);
+                break;
+
+            case MessageTemplate::TokenType::VictimCount:
+            {
+                char count[16];
+                snprintf(count, sizeof(count), "%d", victimCount);
+                messageBuffer.append(count);
+            }
+            break;
+        }
+    }
+
+    PERF_BUFFER(messageBuffer, capacity);
+
+    return messageBuffer;
+}
+
+// Remember a player killed by a mine explosion so it can be announced with everyone else killed by the same shot
+void UselessMine::queueKillAnnouncement(uint32_t shotGUID, ExplosionType type, int shotOwnerID, int mineOwnerID, int victimID)
+{
+    KillAnnouncement *kill = nullptr;
+
+    for (KillAnnouncement &pending : killAnnouncements)
+    {
+        if (pending.shotGUID == shotGUID)
+        {
+            kill = &pending;
+            break;
+        }
+    }
+
+    if (!kill)
+    {
+        if (!callsigns.get(shotOwnerID) || !callsigns.get(mineOwnerID))
+        {
+            return;
+        }
+
+        killAnnouncements.push_back(KillAnnouncement());
+
+        kill = &killAnnouncements.back();
+        kill->shotGUID = shotGUID;
+        kill->type = type;
+        kill->shotOwnerID = shotOwnerID;
+        kill->mineOwnerID = mineOwnerID;
+        kill->ownerKilled = false;
+        kill->sendBy = bz_getCurrentTime() + KILL_ANNOUNCEMENT_WINDOW;
+    }
+
+    if (victimID == mineOwnerID)
+    {
+        kill->ownerKilled = true;
+    }
+    else if (callsigns.get(victimID))
+    {
+        kill->victimIDs.push_back(victimID);
+    }
+}
+
+// Announce the kills of mine explosions. Each client reports its own death, so the deaths from one explosion can arrive
+// over several ticks; with `waitForShots`, an explosion's kills are only announced once its shot has ended or its
+// announcement window has passed.
+void UselessMine::sendKillAnnouncements(bool waitForShots)
+{
+    char victimIDs[AnalyticsLog::MAX_RECORD_SIZE - sizeof(AnalyticsLog::KillsRecord)];
+    double now = bz_getCurrentTime();
+    size_t waiting = 0;
+
+    for (size_t i = 0; i < killAnnouncements.size(); i++)
+    {
+        KillAnnouncement &kill = killAnnouncements[i];
+
+        // Keep the announcements still waiting for victims at the front, in the order their first victim died
+        if (waitForShots && now < kill.sendBy && explosions.get(kill.shotGUID))
+        {
+            if (i != waiting)
+            {
+                std::swap(killAnnouncements[waiting], kill);
+            }
+
+            waiting++;
+            continue;
+        }
+
+        if (analytics.isRunning())
+        {
+            AnalyticsLog::KillsRecord record = {};
+            record.time = now;
+            record.shot = kill.shotGUID;
+            record.shotOwner = (int16_t)kill.shotOwnerID;
+            record.mineOwner = (int16_t)kill.mineOwnerID;
+            record.type = (uint8_t)kill.type;
+            record.ownerKilled = kill.ownerKilled ? 1 : 0;
+            record.victims = (uint8_t)std::min(kill.victimIDs.size(), sizeof(victimIDs));
+
+            for (uint8_t victim = 0; victim < record.victims; victim++)
+            {
+                victimIDs[victim] = (char)kill.victimIDs[victim];
+            }
+
+            analytics.record(AnalyticsLog::RecordType::Kills, record, victimIDs, record.victims);
+        }
+
+        if (kill.type == ExplosionType::Mine)
+        {
+            sendDeathMessage(kill);
+        }
+        else
+        {
+            sendDefuseMessage(kill);
+        }
+    }
+
+    killAnnouncements.resize(waiting);
+}
+
+// Join the callsigns of a player, if firstID isn't -1, and a list of players into a list that reads naturally, such as
+// "a, b and c"
+const std::string& UselessMine::listCallsigns(int firstID, const std::vector<int> &playerIDs)
+{
+    size_t count = playerIDs.size() + (firstID != -1 ? 1 : 0);
+
+    callsignList.clear();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        int playerID = (firstID != -1) ? (i == 0 ? firstID : playerIDs[i - 1]) : playerIDs[i];
+        const char* callsign = callsigns.get(playerID);
+
+        if (i > 0)
+        {
+            callsignList += (i + 1 == count) ? " and " : ", ";
+        }
+
+        callsignList += callsign ? callsign : "";
+    }
+
+    return callsignList;
+}
+
+void UselessMine::sendDefuseMessage(const KillAnnouncement &kill)
+{
+    const char* defuserCallsign = callsigns.get(kill.shotOwnerID);
+    const char* mineOwnerCallsign = callsigns.get(kill.mineOwnerID);
+
+    MessageCatalog defusalMessages = messageLoader.get(MessageLoader::DefusalMessages);
+    bool listedVictims = false;
+
+    if (kill.ownerKilled)
+    {
+        if (defusalMessages->empty())
+        {
+            // Let the BD player know that they killed the owner
+            bz_sendTextMessagef(BZ_SERVER, kill.shotOwnerID, "You defused %s's mine", mineOwnerCallsign);
+
+            // Let the owner know that they were killed by the BD player
+            bz_sendTextMessagef(BZ_SERVER, kill.mineOwnerID, "You were killed by %s's mine defusal", defuserCallsign);
+        }
+        else
+        {
+            // Get a random defusal message; its victims include the owner along with anyone else caught in the blast
+            MessageTemplate::Category category = kill.victimIDs.empty() ? MessageTemplate::Category::Default : MessageTemplate::Category::MultiKill;
+            const MessageTemplate* defusalMessage = defusalMessages->pick(category, random);
+
+            if (defusalMessage)
+            {
+                const std::string &victims = listCallsigns(kill.mineOwnerID, kill.victimIDs);
+
+                bz_sendTextMessage(BZ_SERVER, BZ_ALLUSERS, formatMineMessage(*defusalMessage, mineOwnerCallsign, defuserCallsign,
+                                                                             victims.c_str(), (int)kill.victimIDs.size() + 1).c_str());
+                listedVictims = defusalMessage->listsVictims;
+            }
+        }
+    }
+
+    // If players other than the owner were killed, send a different message
+    if (!kill.victimIDs.empty() && !listedVictims)
+    {
+        bz_sendTextMessagef(BZ_SERVER, BZ_ALLUSERS, "%s %s killed by %s's mine defusal.", listCallsigns(-1, kill.victimIDs).c_str(),
+                            (kill.victimIDs.size() == 1) ? "was" : "were", defuserCallsign);
+    }
+}
+
+void UselessMine::sendDeathMessage(const KillAnnouncement &kill)
+{
+    const char* mineOwnerCallsign = callsigns.get(kill.mineOwnerID);
+
+    MessageCatalog deathMessages = messageLoader.get(MessageLoader::DeathMessages);
+
+    if (kill.victimIDs.empty())
+    {
+        // If the owner was killed with their own mine, send a message
+        if (kill.ownerKilled)
+        {
+            // Messages written for other victims would read wrong here, so only the self category is used
+            const MessageTemplate* selfMessage = deathMessages->pick(MessageTemplate::Category::Self, random, false);
+
+            if (selfMessage)
+            {
+                bz_sendTextMessage(BZ_SERVER, BZ_ALLUSERS, formatMineMessage(*selfMessage, mineOwnerCallsign, mineOwnerCallsign,
+                                                                             mineOwnerCallsign, 1).c_str());
+            }
+            else
+            {
+                bz_sendTextMessagef(BZ_SERVER, BZ_ALLUSERS, "%s was owned by their own mine!", mineOwnerCallsign);
+            }
+        }
+
+        return;
+    }
+
+    MessageTemplate::Category category = MessageTemplate::Category::Default;
+
+    if (playerStates[kill.mineOwnerID].mineKills >= MINE_STREAK_KILLS)
+    {
+        category = MessageTemplate::Category::Streak;
+    }
+    else if (kill.victimIDs.size() > 1)
+    {
+        category = MessageTemplate::Category::MultiKill;
+    }
+
+    const MessageTemplate* deathMessage = deathMessages->pick(category, random);
+
+    if (!deathMessage)
+    {
+        // If there are no death messages, explain to the user that it was a mine that killed them
+        for (int victimID : kill.victimIDs)
+        {
+            bz_sendTextMessagef(BZ_SERVER, victimID, "You were killed by %s's mine", mineOwnerCallsign);
+        }
+
+        if (kill.ownerKilled)
+        {
+            bz_sendTextMessagef(BZ_SERVER, BZ_ALLUSERS, "%s was owned by their own mine!", mineOwnerCallsign);
+        }
+    }
+    else
+    {
+        // Every victim is listed wherever the message names the victim
+        const std::string &victims = listCallsigns(-1, kill.victimIDs);
+        formatMineMessage(*deathMessage, mineOwnerCallsign, victims.c_str(), victims.c_str(), (int)kill.victimIDs.size());
+
+        if (kill.ownerKilled)
+        {
+            messageBuffer += " (";
+            messageBuffer += mineOwnerCallsign;
+            messageBuffer += " was caught in the blast too)";
+        }
+
+        bz_sendTextMessage(BZ_SERVER, BZ_ALLUSERS, messageBuffer.c_str());
+    }
+}
+
+void UselessMine::loadConfiguration(const char *commandline)
+{
+    deathMessagesFile = "";
+    defusalMessagesFile = "";
+    snapshotFile = "";
+
+    // This expects up to three command line parameters: the death messages file, the defusal messages file, and the
+    // file used to keep the mine field while the plug-in is reloaded.
+    bz_APIStringList cmdLineParams;
+    cmdLineParams.tokenize(commandline, ",");
+
+    if (cmdLineParams.size() >= 1)
+    {
+        deathMessagesFile = parsePath(cmdLineParams.get(0));
+    }
+
+    if (cmdLineParams.size() >= 2)
+    {
+        defusalMessagesFile = parsePath(cmdLineParams.get(1));
+    }
+
+    if (cmdLineParams.size() >= 3)
+    {
+        snapshotFile = parsePath(cmdLineParams.get(2));
+    }
+
+    messageLoader.setFile(MessageLoader::DeathMessages, deathMessagesFile);
+    messageLoader.setFile(MessageLoader::DefusalMessages, defusalMessagesFile);
+}
+
+// Fill the player state table for the players already on the server when the plug-in is loaded
+void UselessMine::loadPlayerStates()
+{
+    for (PlayerState &player : playerStates)
+    {
+        player = PlayerState();
+    }
+
+    bz_APIIntList *playerList = bz_newIntList();
+    bz_getPlayerIndexList(playerList);
+
+    for (unsigned int i = 0; i < playerList->size(); i++)
+    {
+        bz_BasePlayerRecord *pr = bz_getPlayerByIndex(playerList->get(i));
+
+        if (!pr)
+        {
+            continue;
+        }
+
+        PlayerState &player = playerStates[pr->playerID];
+        player.connected = true;
+        player.spawned = pr->spawned;
+        player.hasDefusal = (pr->currentFlag == "Bomb Defusal (+BD)");
+        player.team = pr->team;
+        player.spawnTime = 0;
+
+        callsigns.set(pr->playerID, pr->callsign.c_str());
+
+        bz_freePlayerRecord(pr);
+    }
+
+    bz_deleteIntList(playerList);
+}
+
+// Reload the server settings used while checking for mine triggers
+void UselessMine::refreshSettings()
+{
+    settings.shockRange = bz_getBZDBDouble(bzdb_shockOutRadius) * 0.75;
+    settings.safetyTime = bz_getBZDBInt(bzdb_safetyTime);
+    settings.checkInterval = std::max(1, bz_getBZDBInt(bzdb_checkInterval));
+    settings.checkDistance = bz_getBZDBDouble(bzdb_checkDistance);
+    settings.maxTankSpeed = bz_getBZDBDouble(bzdb_tankSpeed) * std::max(1.0, bz_getBZDBDouble(bzdb_velocityAd));
+    settings.tickChecks = bz_getBZDBBool(bzdb_tickChecks);
+    settings.maxPerPlayer = std::max(0, bz_getBZDBInt(bzdb_maxPerPlayer));
+    settings.maxTotal = std::max(0, bz_getBZDBInt(bzdb_maxTotal));
+    settings.perfLogFile = bz_getBZDBString(bzdb_perfLogFile).c_str();
+    settings.perfLogInterval = std::max(1, bz_getBZDBInt(bzdb_perfLogInterval));
+    settings.workerThread = bz_getBZDBBool(bzdb_workerThread);
+
+    std::string analyticsFile = bz_getBZDBString(bzdb_analyticsFile).c_str();
+
+    if (analyticsFile != settings.analyticsFile)
+    {
+        settings.analyticsFile = analyticsFile;
+        startAnalytics();
+    }
+
+    bz_eGameType gameType = bz_getGameType();
+
+    if (gameType != settings.gameType)
+    {
+        settings.gameType = gameType;
+        mineGrid.setGameType(gameType);
+    }
+
+    int lifetime = std::max(0, bz_getBZDBInt(bzdb_lifetime));
+
+    if (lifetime != settings.lifetime)
+    {
+        settings.lifetime = lifetime;
+        rescheduleMineExpiry();
+    }
+
+    if (settings.shockRange != mineGrid.getCellSize())
+    {
+        rebuildMineGrid(settings.shockRange);
+    }
+
+    if (settings.workerThread && !triggerWorker.isRunning())
+    {
+        startTriggerWorker();
+    }
+    else if (!settings.workerThread && triggerWorker.isRunning())
+    {
+        stopTriggerWorker();
+        processWorkerHits();
+    }
+    else if (triggerWorker.isRunning())
+    {
+        sendWorkerConfiguration();
+    }
+
+    // How long players can go without being checked depends on these settings, so check everyone again
+    for (PlayerState &player : playerStates)
+    {
+        player.clearance = 0;
+        player.sleepUntil = 0;
+    }
+}
+
+std::string UselessMine::parsePath(bz_ApiString path)
+{
+    std::string lower = bz_tolower(path.c_str());
+
+    if (lower == "null")
+    {
+        return "";
+    }
+
+    return path;
+}
+
+// Strip the optional [weight=...] and [category=...] tags from the start of a message and apply them
+void UselessMine::parseMessageTags(MessageTemplate &message, const std::string &file, int lineNumber, std::vector<std::string> &warnings)
+{
+    static const char* categoryNames[] = {"default", "self", "multikill", "streak"};
+
+    std::string &text = message.text;
+    size_t start = 0;
+
+    while (start < text.size() && text[start] == '[')
+    {
+        size_t end = text.find(']', start);
+
+        if (end == std::string::npos)
+        {
+            break;
+        }
+
+        std::string tag = text.substr(start + 1, end - start - 1);
+        char warning[256] = "";
+
+        // Anything that isn't a known tag is part of the message itself
+        if (tag.compare(0, 7, "weight=") == 0)
+        {
+            char* parsedTo = nullptr;
+            double weight = strtod(tag.c_str() + 7, &parsedTo);
+
+            if (parsedTo == tag.c_str() + 7 || *parsedTo != '\0' || !(weight > 0))
+            {
+                snprintf(warning, sizeof(warning), "WARNING :: Useless Mine :: Invalid weight \"%s\" on line %d of %s",
+                         tag.c_str() + 7, lineNumber, file.c_str());
+            }
+            else
+            {
+                message.weight = weight;
+            }
+        }
+        else if (tag.compare(0, 9, "category=") == 0)
+        {
+            std::string name = tag.substr(9);
+            int category = 0;
+
+            for (; category < (int)MessageTemplate::Category::Count; category++)
+            {
+                if (name == categoryNames[category])
+                {
+                    break;
+                }
+            }
+
+            if (category == (int)MessageTemplate::Category::Count)
+            {
+                snprintf(warning, sizeof(warning), "WARNING :: Useless Mine :: Unknown category \"%s\" on line %d of %s",
+                         name.c_str(), lineNumber, file.c_str());
+            }
+            else
+            {
+                message.category = (MessageTemplate::Category)category;
+            }
+        }
+        else
+        {
+            break;
+        }
+
+        if (warning[0] != '\0')
+        {
+            warnings.push_back(warning);
+        }
+
+        start = text.find_first_not_of(' ', end + 1);
+
+        if (start == std::string::npos)
+        {
+            start = text.size();
+        }
+    }
+
+    text.erase(0, start);
+}
+
+// Read a file of death or defusal messages and split each line into literal text and placeholders
+void UselessMine::loadMessageTemplates(const std::string &file, std::vector<MessageTemplate> &templates, std::vector<std::string> &warnings)
+{
+    std::vector<std::string> lines = getFileTextLines(file);
+    templates.reserve(lines.size());
+
+    for (size_t lineNumber = 0; lineNumber < lines.size(); lineNumber++)
+    {
+        MessageTemplate message;
+        message.text = lines[lineNumber];
+
+        parseMessageTags(message, file, (int)lineNumber + 1, warnings);
+
+        const std::string &text = message.text;
+        size_t literalStart = 0;
+        size_t search = 0;
+
+        while ((search = text.find('%', search)) != std::string::npos)
+        {
+            size_t end = text.find('%', search + 1);
+
+            if (end == std::string::npos)
+            {
+                break;
+            }
+
+            std::string name = text.substr(search + 1, end - search - 1);
+
+            // Only a run of lowercase letters or underscores between two percent signs is treated as a placeholder;
+            // anything else is a literal percent sign and the closing one could be the start of a placeholder
+            if (name.empty() || name.find_first_not_of("abcdefghijklmnopqrstuvwxyz_") != std::string::npos)
+            {
+                search = end;
+                continue;
+            }
+
+            MessageTemplate::TokenType type;
+
+            if (name == "owner")
+            {
+                type = MessageTemplate::TokenType::Owner;
+            }
+            else if (name == "victim" || name == "defuser")
+            {
+                type = MessageTemplate::TokenType::DefuserOrVictim;
+            }
+            else if (name == "minecount")
+            {
+                type = MessageTemplate::TokenType::MineCount;
+            }
+            else if (name == "victims" || name == "victimcount")
+            {
+                type = (name == "victims") ? MessageTemplate::TokenType::Victims : MessageTemplate::TokenType::VictimCount;
+                message.listsVictims = true;
+            }
+            else
+            {
+                char warning[256];
+                snprintf(warning, sizeof(warning), "WARNING :: Useless Mine :: Unknown placeholder %%%s%% on line %d of %s",
+                         name.c_str(), (int)lineNumber + 1, file.c_str());
+                warnings.push_back(warning);
+
+                search = end + 1;
+                continue;
+            }
+
+            if (search > literalStart)
+            {
+                message.tokens.push_back({MessageTemplate::TokenType::Literal, literalStart, search - literalStart});
+            }
+
+            message.tokens.push_back({type, 0, 0});
+
+            literalStart = end + 1;
+            search = end + 1;
+        }
+
+        if (text.size() > literalStart)
+        {
+            message.tokens.push_back({MessageTemplate::TokenType::Literal, literalStart, text.size() - literalStart});
+        }
+
+        templates.push_back(message);
+    }
+}
+
+// Send the results of background message reloads to the server log and the players who asked for them
+void UselessMine::sendMessageLoaderNotices()
+{
+    std::vector<MessageLoader::Notice> notices;
+    messageLoader.takeNotices(notices);
+
+    for (MessageLoader::Notice &notice : notices)
+    {
+        bz_debugMessage(notice.debugLevel, notice.message.c_str());
+
+        if (notice.playerID >= 0 && !notice.reply.empty())
+        {
+            bz_sendTextMessage(BZ_SERVER, notice.playerID, notice.reply.c_str());
+        }
+    }
+}
+
+const char* UselessMine::getTeamName(bz_eTeamType team)
+{
+    switch (team)
+    {
+        case eRogueTeam:      return "Rogue";
+        case eRedTeam:        return "Red Team";
+        case eGreenTeam:      return "Green Team";
+        case eBlueTeam:       return "Blue Team";
+        case ePurpleTeam:     return "Purple Team";
+        case eRabbitTeam:     return "Rabbit";
+        case eHunterTeam:     return "Hunters";
+        default:              return "Unknown";
+    }
+}
+
+// Get the amount of active mines that exist
+int UselessMine::getMineCount()
+{
+    return (int)activeMines.size();
+}
+
+// Decide whether a player's new position needs to be checked for triggered mines and check the path they took to it
+void UselessMine::handlePlayerPosition(int playerID, const float pos[3])
+{
+    PlayerState &player = playerStates[playerID];
+    double now = bz_getCurrentTime();
+
+    if (player.hasCheckedPos)
+    {
+        double dx = pos[0] - player.checkedPos[0], dy = pos[1] - player.checkedPos[1], dz = pos[2] - player.checkedPos[2];
+        double distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+        // A player moving faster than a tank can drive went through a teleporter, so don't sweep the path between the
+        // two teleporters
+        if (distance > settings.maxTankSpeed * 2 * (now - player.checkedTime) + settings.shockRange)
+        {
+            player.hasCheckedPos = false;
+        }
+        else
+        {
+            player.updatesSinceCheck++;
+            player.distanceSinceCheck += distance;
+
+            bool safetyTimeEnded = (player.checkedInSafetyTime && player.spawnTime + settings.safetyTime <= now);
+            bool minesPlaced = (player.checkedMineVersion != mineFieldVersion);
+            bool sleeping = (now < player.sleepUntil);
+            bool skipCheck = (player.updatesSinceCheck < (unsigned int)settings.checkInterval || player.distanceSinceCheck < settings.checkDistance) &&
+                             !safetyTimeEnded && !minesPlaced;
+
+            // A player who can't have reached a mine yet doesn't need to be checked; placing a mine close enough to
+            // matter wakes them up. An update is only ever skipped while the player is still closer to where the clearance
+            // was measured than to any mine they could set off. That area is convex, so the straight path between any two
+            // skipped updates stays inside of it too, and the next check only has to sweep from the last skipped update.
+            if (sleeping || skipCheck)
+            {
+                double sx = pos[0] - player.clearancePos[0], sy = pos[1] - player.clearancePos[1], sz = pos[2] - player.clearancePos[2];
+
+                if (sx * sx + sy * sy + sz * sz < player.clearance * player.clearance)
+                {
+                    // The path since the last update stayed clear of every mine, which is as good as checking it
+                    player.checkedPos[0] = pos[0];
+                    player.checkedPos[1] = pos[1];
+                    player.checkedPos[2] = pos[2];
+                    player.checkedTime = now;
+
+                    if (sleeping)
+                    {
+                        player.updatesSinceCheck = 0;
+                        player.distanceSinceCheck = 0;
+                        player.checkedMineVersion = mineFieldVersion;
+
+                        PERF_COUNT(UpdatesSlept, 1);
+                    }
+
+                    return;
+                }
+
+                player.sleepUntil = 0;
+            }
+        }
+    }
+
+    if (!player.hasCheckedPos)
+    {
+        player.checkedPos[0] = pos[0];
+        player.checkedPos[1] = pos[1];
+        player.checkedPos[2] = pos[2];
+    }
+
+    float from[3] = {player.checkedPos[0], player.checkedPos[1], player.checkedPos[2]};
+    float to[3] = {pos[0], pos[1], pos[2]};
+
+    player.hasCheckedPos = true;
+    player.checkedPos[0] = to[0];
+    player.checkedPos[1] = to[1];
+    player.checkedPos[2] = to[2];
+    player.checkedTime = now;
+    player.updatesSinceCheck = 0;
+    player.distanceSinceCheck = 0;
+    player.checkedMineVersion = mineFieldVersion;
+    player.checkedInSafetyTime = (player.spawnTime + settings.safetyTime > now);
+
+    checkForTriggeredMines(playerID, from, to);
+}
+
+// Check every player who moved since the last tick. Players are checked in order of their player ID so when several
+// players reach the same mine during a tick, the same player sets it off no matter what order their updates came in.
+void UselessMine::checkPendingPlayers()
+{
+    if (pendingPlayers.empty())
+    {
+        return;
+    }
+
+    std::sort(pendingPlayers.begin(), pendingPlayers.end());
+
+    for (int playerID : pendingPlayers)
+    {
+        PlayerState &player = playerStates[playerID];
+
+        // The player may have died, respawned, or left since their position was recorded
+        if (!player.hasPendingPos)
+        {
+            continue;
+        }
+
+        player.hasPendingPos = false;
+        handlePlayerPosition(playerID, player.pendingPos);
+    }
+
+    pendingPlayers.clear();
+}
+
+// Check if a player triggered any mines while moving from one position to another, and set off the first one
+void UselessMine::checkForTriggeredMines(int playerID, const float from[3], const float to[3])
+{
+    const PlayerState &player = playerStates[playerID];
+    bool bypassSafetyTime = (player.spawnTime + settings.safetyTime <= bz_getCurrentTime());
+
+    if (!player.spawned || !bypassSafetyTime)
+    {
+        return;
+    }
+
+    if (triggerWorker.isRunning())
+    {
+        TriggerWorker::Command command;
+        command.type = TriggerWorker::Command::Type::Check;
+        command.playerID = playerID;
+        command.team = player.team;
+        command.spawnTime = player.spawnTime;
+        std::copy(from, from + 3, command.from);
+        std::copy(to, to + 3, command.to);
+
+        // The position is checked right away on this thread instead if the worker has fallen too far behind
+        if (triggerWorker.send(command))
+        {
+            PERF_COUNT(UpdatesChecked, 1);
+            return;
+        }
+    }
+
+    size_t capacity = nearbyMines.capacity();
+    unsigned int scanned = mineGrid.query(from, to, playerID, player.team, nearbyMines);
+
+    PERF_COUNT(UpdatesChecked, 1);
+    PERF_COUNT(MinesScanned, scanned);
+    PERF_COUNT(CandidateHits, nearbyMines.size());
+    PERF_BUFFER(nearbyMines, capacity);
+
+    MineStore::TriggerTest canTrigger = MineStore::selectTriggerTest(settings.gameType, player.team);
+    bool minesNearby = !nearbyMines.empty();
+
+    for (const GridEntry &entry : nearbyMines)
+    {
+        MineHandle mine = entry.second;
+
+        // Only stop at a mine that was successfully triggered; otherwise the mine's owner can't be blamed for it
+        // right now so move on to check the next mine
+        if (canTrigger(activeMines, activeMines.indexOf(mine), playerID, player.team, from, to, settings.shockRange) && triggerMine(playerID, mine, to))
+        {
+            break;
+        }
+    }
+
+    scheduleNextCheck(playerID, to, minesNearby);
+}
+
+// Work out how long a player can't possibly reach any mine they could trigger, so their updates until then can be skipped.
+// A player whose check already found mines in the cells around them is too close to one to skip much, so the distance
+// isn't worth measuring.
+void UselessMine::scheduleNextCheck(int playerID, const float pos[3], bool minesNearby)
+{
+    PlayerState &player = playerStates[playerID];
+
+    player.clearancePos[0] = pos[0];
+    player.clearancePos[1] = pos[1];
+    player.clearancePos[2] = pos[2];
+    player.clearance = 0;
+    player.sleepUntil = 0;
+
+    if (minesNearby)
+    {
+        return;
+    }
+
+    unsigned int scanned;
+    player.clearance = mineGrid.hostileClearance(pos, playerID, player.team, settings.shockRange, SLEEP_SEARCH_CELLS, scanned);
+
+    PERF_COUNT(ClearanceScans, 1);
+    PERF_COUNT(ClearanceCells, scanned);
+
+    // Anything moving faster than the teleport check in handlePlayerPosition allows is treated as a teleport and checked
+    // right away, so only movement within that allowance has to be accounted for
+    if (settings.maxTankSpeed > 0 && player.clearance > settings.shockRange)
+    {
+        player.sleepUntil = bz_getCurrentTime() + (player.clearance - settings.shockRange) / (settings.maxTankSpeed * 2);
+    }
+}
+
+// Detonate or defuse a mine a player ran into; returns false if the mine couldn't be set off
+bool UselessMine::triggerMine(int playerID, MineHandle mine, const float pos[3])
+{
+    const PlayerState &player = playerStates[playerID];
+
+    PERF_COUNT(MinesInRange, 1);
+    TRACE_MESSAGE("DEBUG :: Useless Mine :: player %d located inside mine #%u trigger", playerID, mine);
+    TRACE_EVENT(TraceType::InRange, playerID, mine, pos);
+
+    bool mineWentBoom = player.hasDefusal ? defuseMine(mine, playerID) : detonateMine(mine, playerID);
+
+    TRACE_EVENT(mineWentBoom ? (player.hasDefusal ? TraceType::Defused : TraceType::Detonated) : TraceType::Ignored,
+                playerID, mine, pos);
+
+    if (mineWentBoom)
+    {
+        PERF_COUNT(Detonations, 1);
+        removeMine(mine);
+    }
+
+    return mineWentBoom;
+}
+
+// Start checking for triggered mines on a background thread, giving it a copy of the current mine field
+void UselessMine::startTriggerWorker()
+{
+    triggerWorker.start(proximityKernel);
+    sendWorkerConfiguration();
+
+    std::vector<unsigned int> order(activeMines.size());
+
+    for (unsigned int i = 0; i < order.size(); i++)
+    {
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) {
+        return activeMines.seq[a] < activeMines.seq[b];
+    });
+
+    for (unsigned int i : order)
+    {
+        sendWorkerMine(TriggerWorker::Command::Type::AddMine, activeMines.handle[i]);
+    }
+
+    bz_debugMessage(2, "DEBUG :: Useless Mine :: Checking for triggered mines on a background thread");
+}
+
+void UselessMine::stopTriggerWorker()
+{
+    if (!triggerWorker.isRunning())
+    {
+        return;
+    }
+
+    triggerWorker.stop();
+
+    bz_debugMessage(2, "DEBUG :: Useless Mine :: Stopped checking for triggered mines on a background thread");
+}
+
+void UselessMine::sendWorkerConfiguration()
+{
+    TriggerWorker::Command command;
+    command.type = TriggerWorker::Command::Type::Configure;
+    command.shockRange = settings.shockRange;
+    command.gameType = settings.gameType;
+
+    while (!triggerWorker.send(command))
+    {
+        processWorkerHits();
+        std::this_thread::yield();
+    }
+}
+
+// Tell the background thread about a mine being placed or removed; mine changes can't be dropped, so this waits for
+// room in the queue, acting on the worker's results meanwhile so it can't get stuck waiting on this thread
+void UselessMine::sendWorkerMine(TriggerWorker::Command::Type type, MineHandle mine)
+{
+    if (!triggerWorker.isRunning())
+    {
+        return;
+    }
+
+    TriggerWorker::Command command;
+    command.type = type;
+    command.mine = mine;
+
+    if (type == TriggerWorker::Command::Type::AddMine)
+    {
+        unsigned int i = activeMines.indexOf(mine);
+
+        command.seq = activeMines.seq[i];
+        command.playerID = activeMines.owner[i];
+        command.team = activeMines.team[i];
+        command.to[0] = activeMines.x[i];
+        command.to[1] = activeMines.y[i];
+        command.to[2] = activeMines.z[i];
+    }
+
+    while (!triggerWorker.send(command))
+    {
+        processWorkerHits();
+        std::this_thread::yield();
+    }
+}
+
+// Act on the mines the background thread found players touching. Everything is checked again against the current state
+// of the game, since mines may have been removed or players may have died since the worker looked at them.
+//
+// Setting off a mine sends the worker a RemoveMine command, which may have to wait for room in the queue and call this
+// again. That nested call only takes the new hits off the queue so the worker can keep going; they're acted on in order
+// by the outer call once it gets to them.
+void UselessMine::processWorkerHits()
+{
+    TriggerWorker::Hit hit;
+
+    while (triggerWorker.takeHit(hit))
+    {
+        workerHits.push_back(hit);
+    }
+
+    if (processingWorkerHits)
+    {
+        return;
+    }
+
+    processingWorkerHits = true;
+
+    // The list may grow while mines are being set off, so it's walked by index and each hit is copied
+    for (size_t n = 0; n < workerHits.size(); n++)
+    {
+        hit = workerHits[n];
+
+        // Only one mine can go off for each position that was checked
+        if (hit.check == triggeredWorkerCheck)
+        {
+            continue;
+        }
+
+        const PlayerState &player = playerStates[hit.playerID];
+
+        if (!activeMines.isValid(hit.mine) || !player.spawned || player.spawnTime != hit.spawnTime)
+        {
+            continue;
+        }
+
+        if (activeMines.canPlayerTriggerMine(activeMines.indexOf(hit.mine), hit.playerID, player, hit.from, hit.to, settings) &&
+            triggerMine(hit.playerID, hit.mine, hit.to))
+        {
+            triggeredWorkerCheck = hit.check;
+        }
+    }
+
+    workerHits.clear();
+    processingWorkerHits = false;
+}
+
+// Remove a specific mine
+void UselessMine::removeMine(MineHandle mine)
+{
+    if (!activeMines.isValid(mine))
+    {
+        return;
+    }
+
+    unsigned int i = activeMines.indexOf(mine);
+    float minePos[3] = {activeMines.x[i], activeMines.y[i], activeMines.z[i]};
+
+    TRACE_MESSAGE("DEBUG :: Useless Mine :: Removing mine #%u", mine);
+    TRACE_EVENT(TraceType::Removed, activeMines.owner[i], mine, minePos);
+
+    mineGrid.remove(mine, minePos[0], minePos[1], activeMines.team[i]);
+    activeMines.remove(mine);
+    sendWorkerMine(TriggerWorker::Command::Type::RemoveMine, mine);
+
+    TRACE_MESSAGE("DEBUG :: Useless Mine ::   new mine count: %d", getMineCount());
+}
+
+// Remove all of the mines of a specific player
+void UselessMine::removePlayerMines(int playerID)
+{
+    TRACE_MESSAGE("DEBUG :: Useless Mine :: Removing all mines for player %d", playerID);
 
-            // Only handle shots that have this plugin's metadata
-            if (bz_shotHasMetaData(shotGUID, Mine::ww_shotType))
-            {
-                ExplosionType shotType = (ExplosionType)bz_getShotMetaDataI(shotGUID, Mine::ww_shotType);
+    for (MineHandle mine = activeMines.oldestOwnedBy(playerID); mine != MineStore::INVALID_HANDLE; mine = activeMines.oldestOwnedBy(playerID))
+    {
+        unsigned int i = activeMines.indexOf(mine);
 
-                // Reassign the killer ID to the mine owner or the bomb defuser
-                if (shotType == ExplosionType::Mine || shotType == ExplosionType::Defusal)
-                {
-                    int shotOwnerID = bz_getShotMetaDataI(shotGUID, Mine::ww_shotOwner);
-                    int mineOwnerID = bz_getShotMetaDataI(shotGUID, Mine::ww_mineOwner);
+        recordMineRemoved(mine, AnalyticsLog::RemoveReason::OwnerLeft);
+        mineGrid.remove(mine, activeMines.x[i], activeMines.y[i], activeMines.team[i]);
+        activeMines.remove(mine);
+        sendWorkerMine(TriggerWorker::Command::Type::RemoveMine, mine);
+    }
+}
 
-                    dieData->killerID = shotOwnerID;
+// Remove the mines that have outlived _mineLifetime
+void UselessMine::removeExpiredMines()
+{
+    double now = bz_getCurrentTime();
 
-                    if (shotType == ExplosionType::Mine)
-                    {
-                        sendDeathMessage(mineOwnerID, victimID);
-                    }
-                    else if (shotType == ExplosionType::Defusal)
-                    {
-                        sendDefuseMessage(shotOwnerID, mineOwnerID, victimID);
-                    }
-                }
-            }
-        }
-        break;
+    expiredMines.clear();
+    mineExpiry.advance(now, expiredMines);
 
-        case bz_ePlayerPartEvent:
+    for (MineHandle mine : expiredMines)
+    {
+        // Timers aren't cancelled, so the mine may already be gone or its lifetime may have been extended since
+        if (!activeMines.isValid(mine))
         {
-            bz_PlayerJoinPartEventData_V1* partData = (bz_PlayerJoinPartEventData_V1*)eventData;
+            continue;
+        }
 
-            int playerID = partData->playerID;
+        double expiresAt = activeMines.expiresAt[activeMines.indexOf(mine)];
 
-            // Remove all the mines belonging to the player who just left
-            removePlayerMines(playerID);
-            playerSpawnTime[playerID] = -1;
+        if (expiresAt > 0 && expiresAt <= now)
+        {
+            TRACE_MESSAGE("DEBUG :: Useless Mine :: Mine #%u expired", mine);
+            recordMineRemoved(mine, AnalyticsLog::RemoveReason::Expired);
+            removeMine(mine);
         }
-        break;
+    }
+}
 
-        case bz_ePlayerSpawnEvent:
-        {
-            bz_PlayerSpawnEventData_V1* spawnData = (bz_PlayerSpawnEventData_V1*)eventData;
+// Recalculate when every mine expires after _mineLifetime has changed
+void UselessMine::rescheduleMineExpiry()
+{
+    mineExpiry.reset(bz_getCurrentTime());
 
-            int playerID = spawnData->playerID;
+    for (unsigned int i = 0; i < activeMines.size(); i++)
+    {
+        activeMines.expiresAt[i] = (settings.lifetime > 0) ? activeMines.placedAt[i] + settings.lifetime : 0;
 
-            // Save the time the player spawned last
-            playerSpawnTime[playerID] = bz_getCurrentTime();
+        if (activeMines.expiresAt[i] > 0)
+        {
+            mineExpiry.schedule(activeMines.handle[i], activeMines.expiresAt[i]);
         }
-        break;
+    }
+}
 
-        case bz_ePlayerUpdateEvent:
-        {
-            bz_PlayerUpdateEventData_V1* updateData = (bz_PlayerUpdateEventData_V1*)eventData;
+// Rebuild the spatial index of mines using a new cell size
+void UselessMine::rebuildMineGrid(double cellSize)
+{
+    TRACE_MESSAGE("DEBUG :: Useless Mine :: Rebuilding mine grid with cell size %0.2f", cellSize);
 
-            int playerID = updateData->playerID;
-            bool bypassSafetyTime = (playerSpawnTime[playerID] + bz_getBZDBInt(bzdb_safetyTime) <= bz_getCurrentTime());
-            bz_BasePlayerRecord *pr = bz_getPlayerByIndex(playerID);
+    mineGrid.reset(cellSize);
+    mineGrid.insertAll(activeMines, 0);
+}
 
-            bz_debugMessagef(DEBUG_VERBOSITY, "DEBUG :: Useless Mine :: player #%d at {%0.2f, %0.2f, %0.2f}",
-                             playerID, updateData->state.pos[0], updateData->state.pos[1], updateData->state.pos[2]);
+// Write the mine field to the snapshot file so it can be restored the next time the plug-in is loaded
+void UselessMine::saveMineSnapshot()
+{
+    if (snapshotFile.empty() || getMineCount() == 0)
+    {
+        return;
+    }
 
-            for (Mine &mine : activeMines)
-            {
-                if (mine.canPlayerTriggerMine(pr, updateData->state.pos) && bypassSafetyTime)
-                {
-                    bz_debugMessagef(DEBUG_VERBOSITY, "DEBUG :: Useless Mine :: player %d located inside mine %s trigger",
-                                     playerID, mine.uid.c_str());
+    MineSnapshot snapshot;
+    snapshot.mines.reserve(activeMines.size());
 
-                    bool mineWentBoom = (pr->currentFlag == "Bomb Defusal (+BD)") ? mine.defuse(playerID) : mine.detonate();
+    // Write mines in the order they were placed so they keep their relative age when they're restored
+    std::vector<unsigned int> order(activeMines.size());
 
-                    // Only break if we successfully triggered a mine; otherwise we're just in the same area as a stale
-                    // mine so move on to check the next mine
-                    if (mineWentBoom)
-                    {
-                        removeMine(mine);
-                        break;
-                    }
-                }
-            }
+    for (unsigned int i = 0; i < order.size(); i++)
+    {
+        order[i] = i;
+    }
 
-            bz_freePlayerRecord(pr);
-        }
-        break;
+    std::sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) {
+        return activeMines.seq[a] < activeMines.seq[b];
+    });
 
-        default:
-            break;
-    }
-}
+    int ownerIndex[MineStore::MAX_PLAYERS];
+    std::fill(ownerIndex, ownerIndex + MineStore::MAX_PLAYERS, -1);
 
-bool UselessMine::SlashCommand(int playerID, bz_ApiString command, bz_ApiString /*message*/, bz_APIStringList *params)
-{
-    if (command == "mine")
+    double now = bz_getCurrentTime();
+
+    for (unsigned int i : order)
     {
-        bz_BasePlayerRecord *pr = bz_getPlayerByIndex(playerID);
+        int owner = activeMines.owner[i];
 
-        if (pr->team != eObservers)
+        if (ownerIndex[owner] == -1)
         {
-            // Check if the player has the Useless flag
-            if (pr->currentFlag == "USeless (+US)")
-            {
-                // Store their current position
-                float currentPosition[3] = {pr->lastKnownState.pos[0], pr->lastKnownState.pos[1], pr->lastKnownState.pos[2]};
+            bz_BasePlayerRecord *pr = bz_getPlayerByIndex(owner);
 
-                setMine(playerID, currentPosition, pr->team);
+            if (pr)
+            {
+                ownerIndex[owner] = (int)snapshot.owners.size();
+                snapshot.owners.push_back(MineSnapshot::Owner{pr->callsign.c_str(), pr->bzID.c_str()});
             }
             else
             {
-                bz_sendTextMessage(BZ_SERVER, playerID, "You can't place a mine without the Useless flag!");
+                ownerIndex[owner] = -2;
             }
+
+            bz_freePlayerRecord(pr);
         }
-        else
+
+        if (ownerIndex[owner] < 0)
         {
-            bz_sendTextMessage(BZ_SERVER, playerID, "Silly observer, you can't place a mine.");
+            continue;
         }
 
-        bz_freePlayerRecord(pr);
+        MineSnapshot::Mine mine = {
+            {activeMines.x[i], activeMines.y[i], activeMines.z[i]},
+            (float)(now - activeMines.placedAt[i]),
+            (uint16_t)ownerIndex[owner],
+            (uint8_t)activeMines.team[i],
+            0
+        };
+        snapshot.mines.push_back(mine);
+    }
 
-        return true;
+    if (!snapshot.save(snapshotFile))
+    {
+        bz_debugMessagef(2, "WARNING :: Useless Mine :: Could not write the mine snapshot to %s", snapshotFile.c_str());
+        return;
     }
-    else if (command == "minecount")
+
+    bz_debugMessagef(2, "DEBUG :: Useless Mine :: Saved %d mines to %s", (int)snapshot.mines.size(), snapshotFile.c_str());
+}
+
+// Put back the mines saved when the plug-in was last unloaded, as long as their owners are still on the server
+void UselessMine::restoreMineSnapshot()
+{
+    if (snapshotFile.empty())
     {
-        bz_sendTextMessagef(BZ_SERVER, playerID, "There are currently %d active mines on the field", getMineCount());
+        return;
+    }
 
-        return true;
+    MineSnapshot snapshot;
+    bool loaded = snapshot.load(snapshotFile);
+
+    // A snapshot is only good for one reload; mines restored after a server restart would belong to the wrong players
+    bool existed = (remove(snapshotFile.c_str()) == 0);
+
+    if (!loaded)
+    {
+        if (existed)
+        {
+            bz_debugMessagef(2, "WARNING :: Useless Mine :: The mine snapshot in %s is invalid and was ignored", snapshotFile.c_str());
+        }
+
+        return;
     }
-    else if (command == "minestats")
+
+    // Match the owners in the snapshot with the players on the server, preferring their BZID when they have one
+    std::vector<int> ownerIDs(snapshot.owners.size(), -1);
+
+    bz_APIIntList *playerList = bz_newIntList();
+    bz_getPlayerIndexList(playerList);
+
+    for (unsigned int i = 0; i < playerList->size(); i++)
     {
-        bz_sendTextMessagef(BZ_SERVER, playerID, "Player Mines");
-        bz_sendTextMessagef(BZ_SERVER, playerID, "------------");
+        bz_BasePlayerRecord *pr = bz_getPlayerByIndex(playerList->get(i));
 
-        std::map<std::string, int> mineCount;
+        if (!pr)
+        {
+            continue;
+        }
 
-        for (Mine &mine : activeMines)
+        for (size_t j = 0; j < snapshot.owners.size(); j++)
         {
-            if (mine.isStale())
+            const MineSnapshot::Owner &owner = snapshot.owners[j];
+
+            if (owner.bzID.empty() ? (owner.callsign == pr->callsign.c_str()) : (owner.bzID == pr->bzID.c_str()))
             {
-                continue;
+                ownerIDs[j] = pr->playerID;
             }
-
-            mineCount[bz_getPlayerCallsign(mine.owner)]++;
         }
 
-        rmap mineList;
+        bz_freePlayerRecord(pr);
+    }
+
+    bz_deleteIntList(playerList);
+
+    double now = bz_getCurrentTime();
+    int restored = 0;
+
+    unsigned int first = activeMines.size();
+    activeMines.reserve(first + snapshot.mines.size());
 
-        for (auto i : mineCount)
+    for (const MineSnapshot::Mine &mine : snapshot.mines)
+    {
+        if (mine.owner >= ownerIDs.size() || ownerIDs[mine.owner] < 0 || mine.team >= MineStore::MAX_TEAMS || activeMines.isFull())
         {
-            mineList.insert(rmap::value_type(i.second, i.first));
+            continue;
         }
 
-        for (auto i : mineList)
+        double placedAt = now - mine.age;
+        double expiresAt = (settings.lifetime > 0) ? placedAt + settings.lifetime : 0;
+
+        MineHandle handle = activeMines.add(nextMineSeq++, ownerIDs[mine.owner], mine.pos, (bz_eTeamType)mine.team, placedAt, expiresAt);
+
+        if (expiresAt > 0)
         {
-            bz_sendTextMessagef(BZ_SERVER, playerID, "%-32s %d", i.second.c_str(), i.first);
+            mineExpiry.schedule(handle, expiresAt);
         }
 
-        return true;
+        restored++;
     }
-    else if (command == "reload" && bz_hasPerm(playerID, "setAll"))
+
+    mineGrid.insertAll(activeMines, first);
+    mineFieldVersion++;
+
+    // The background thread may already be running with the mine field as it was before the snapshot
+    for (unsigned int i = first; i < activeMines.size(); i++)
     {
-        if (params->size() == 0)
-        {
-            reloadDeathMessages();
-            reloadDefusalMessages();
-        }
+        sendWorkerMine(TriggerWorker::Command::Type::AddMine, activeMines.handle[i]);
+    }
 
-        else if (params->get(0) == "deathmessages")
+    bz_debugMessagef(2, "DEBUG :: Useless Mine :: Restored %d of %d mines from %s", restored, (int)snapshot.mines.size(), snapshotFile.c_str());
+}
+
+// A shortcut to set a mine
+void UselessMine::setMine(int owner, float pos[3], bz_eTeamType team)
+{
+    // Make room for the new mine by removing the oldest ones once a limit has been reached
+    if (settings.maxPerPlayer > 0)
+    {
+        bool evicted = false;
+
+        while (activeMines.countForOwner(owner) >= settings.maxPerPlayer)
         {
-            reloadDeathMessages();
-            bz_sendTextMessage(BZ_SERVER, playerID, "Death messages reloaded");
-            return true;
+            recordMineRemoved(activeMines.oldestOwnedBy(owner), AnalyticsLog::RemoveReason::Replaced);
+            removeMine(activeMines.oldestOwnedBy(owner));
+            evicted = true;
         }
 
-        else if (params->get(0) == "defusalmessages")
+        if (evicted)
         {
-            reloadDefusalMessages();
-            bz_sendTextMessage(BZ_SERVER, playerID, "Defusal messages reloaded");
-            return true;
+            bz_sendTextMessage(BZ_SERVER, owner, "Your oldest mine was removed to make room for this one.");
         }
     }
 
-    return false;
-}
+    while (activeMines.isFull() || (settings.maxTotal > 0 && (int)activeMines.size() >= settings.maxTotal))
+    {
+        recordMineRemoved(activeMines.oldest(), AnalyticsLog::RemoveReason::Replaced);
+        removeMine(activeMines.oldest());
+    }
 
-// A function to format death messages in order to replace placeholders with callsigns and values
-std::string UselessMine::formatMineMessage(std::string msg, std::string mineOwner, std::string defuserOrVictim)
-{
-    bz_ApiString formattedMessage = msg;
-    formattedMessage.replaceAll("%owner%", mineOwner.c_str());
-    formattedMessage.replaceAll("%victim%", defuserOrVictim.c_str());
-    formattedMessage.replaceAll("%defuser%", defuserOrVictim.c_str());
-    formattedMessage.replaceAll("%minecount%", std::to_string(getMineCount()).c_str());
+    // Remove their flag because they "converted" it into a mine
+    bz_removePlayerFlag(owner);
 
-    return formattedMessage;
-}
+    double now = bz_getCurrentTime();
+    double expiresAt = (settings.lifetime > 0) ? now + settings.lifetime : 0;
 
-void UselessMine::sendDefuseMessage(int defuserID, int mineOwnerID, int victimID)
-{
-    const char* defuserCallsign = bz_getPlayerCallsign(defuserID);
-    const char* mineOwnerCallsign = bz_getPlayerCallsign(mineOwnerID);
-    const char* victimCallsign = bz_getPlayerCallsign(victimID);
+    unsigned int seq = nextMineSeq++;
+    MineHandle mine = activeMines.add(seq, owner, pos, team, now, expiresAt);
+    mineGrid.insert(activeMines, activeMines.indexOf(mine));
+    sendWorkerMine(TriggerWorker::Command::Type::AddMine, mine);
 
-    if (!defuserCallsign || !mineOwnerCallsign || !victimCallsign)
+    if (analytics.isRunning())
     {
-        return;
+        AnalyticsLog::PlacedRecord record = {};
+        record.time = now;
+        std::copy(pos, pos + 3, record.pos);
+        record.mine = seq;
+        record.owner = (int16_t)owner;
+        record.team = (uint8_t)team;
+
+        analytics.record(AnalyticsLog::RecordType::MinePlaced, record);
     }
 
-    if (victimID == mineOwnerID)
+    if (expiresAt > 0)
     {
-        if (defusalMessages.empty())
-        {
-            // Let the BD player know that they killed the owner
-            bz_sendTextMessagef(BZ_SERVER, defuserID, "You defused %s's mine", mineOwnerCallsign);
+        mineExpiry.schedule(mine, expiresAt);
+    }
 
-            // Let the owner know that they were killed by the BD player
-            bz_sendTextMessagef(BZ_SERVER, mineOwnerID, "You were killed by %s's mine defusal", defuserCallsign);
-        }
-        else
-        {
-            // The random number used to fetch a random taunting defusal message
-            int randomNumber = rand() % defusalMessages.size();
+    mineFieldVersion++;
 
-            // Get a random defusal message
-            std::string defusalMessage = defusalMessages.at(randomNumber);
-            bz_sendTextMessage(BZ_SERVER, BZ_ALLUSERS, formatMineMessage(defusalMessage, mineOwnerCallsign, defuserCallsign).c_str());
-        }
-    }
-    else
+    // Wake up anyone who could reach the new mine sooner than the mines they were scheduled around, and stop them from
+    // skipping updates until their next check measures how far they are from it
+    for (PlayerState &player : playerStates)
     {
-        // If the victim wasn't the owner, then send a different message
-        bz_sendTextMessagef(BZ_SERVER, BZ_ALLUSERS, "%s was killed by %s's mine defusal.", victimCallsign, defuserCallsign);
+        if (player.clearance > 0 && &player != &playerStates[owner] &&
+            std::max(std::fabs(pos[0] - player.clearancePos[0]), std::fabs(pos[1] - player.clearancePos[1])) - settings.shockRange < player.clearance)
+        {
+            player.clearance = 0;
+            player.sleepUntil = 0;
+        }
     }
+
+    TRACE_MESSAGE("DEBUG :: Useless Mine :: Mine #%u created by %d", mine, owner);
+    TRACE_MESSAGE("DEBUG :: Useless Mine ::   x, y, z => %0.2f, %0.2f, %0.2f", pos[0], pos[1], pos[2]);
+    TRACE_EVENT(TraceType::Placed, owner, mine, pos);
 }
 
-void UselessMine::sendDeathMessage(int mineOwner, int victimID)
+// This sets the mine for defusal - the mine will trigger, but
+// will instead trigger at the location of the owner, with the
+// killer ID being that of the defuser.
+bool UselessMine::defuseMine(MineHandle mine, int defuserID)
 {
-    const char* mineOwnerCallsign = bz_getPlayerCallsign(mineOwner);
+    int owner = activeMines.owner[activeMines.indexOf(mine)];
+    bz_BasePlayerRecord *pr = bz_getPlayerByIndex(owner);
 
-    if (!mineOwnerCallsign)
+    if (!pr || pr->team == eObservers)
     {
-        return;
+        bz_freePlayerRecord(pr);
+        return false;
     }
 
-    if (victimID == mineOwner)
-    {
-        // If the owner was killed with their own mine, send a message
-        bz_sendTextMessagef(BZ_SERVER, BZ_ALLUSERS, "%s was owned by their own mine!", mineOwnerCallsign);
+    TRACE_MESSAGE("DEBUG :: Useless Mine :: Mine #%u defused by %d", mine, defuserID);
 
-        return;
-    }
+    float vector[3] = {0, 0, 0};
+    uint32_t detonationShotID = bz_fireServerShot("SW", pr->lastKnownState.pos, vector, bz_getPlayerTeam(defuserID));
+    explosions.add(detonationShotID, ExplosionType::Defusal, defuserID, owner, bz_getCurrentTime());
+    recordMineTriggered(AnalyticsLog::RecordType::MineDefused, mine, detonationShotID, defuserID);
+
+    bz_freePlayerRecord(pr);
+
+    return true;
+}
 
-    if (deathMessages.empty())
+// This sets the mine for detonation - the mine will trigger,
+// killing the victim and setting the killer as the mine
+// owner.
+bool UselessMine::detonateMine(MineHandle mine, int triggeredBy)
+{
+    unsigned int i = activeMines.indexOf(mine);
+    int owner = activeMines.owner[i];
+
+    if (bz_getPlayerTeam(owner) == eObservers)
     {
-        // If there are no death messages, explain to the user that it was a mine that killed them
-        bz_sendTextMessagef(BZ_SERVER, victimID, "You were killed by %s's mine", mineOwnerCallsign);
+        return false;
     }
-    else
-    {
-        // The random number used to fetch a random taunting death message
-        int randomNumber = rand() % deathMessages.size();
-        std::string deathMessage = deathMessages.at(randomNumber);
 
-        const char* mineVictimCallsign = bz_getPlayerCallsign(victimID);
+    float minePos[3] = {activeMines.x[i], activeMines.y[i], activeMines.z[i]};
+    float vector[3] = {0, 0, 0};
 
-        if (!mineVictimCallsign)
-        {
-            return;
-        }
+    TRACE_MESSAGE("DEBUG :: Useless Mine :: Mine #%u detonated", mine);
 
-        bz_sendTextMessage(BZ_SERVER, BZ_ALLUSERS, formatMineMessage(deathMessage, mineOwnerCallsign, mineVictimCallsign).c_str());
-    }
+    // Fire the world weapon
+    uint32_t detonationShotID = bz_fireServerShot("SW", minePos, vector, activeMines.team[i]);
+    explosions.add(detonationShotID, ExplosionType::Mine, owner, owner, bz_getCurrentTime());
+    recordMineTriggered(AnalyticsLog::RecordType::MineDetonated, mine, detonationShotID, triggeredBy);
+
+    return true;
 }
 
-void UselessMine::loadConfiguration(const char *commandline)
+// Summarize the performance statistics as lines of text for an admin or the performance log
+void UselessMine::formatPerfStats(std::vector<std::string> &lines)
 {
-    deathMessagesFile = "";
-    defusalMessagesFile = "";
+    char line[160];
 
-    // This expects two command line parameters: the death messages file and the defusal messages file.
-    bz_APIStringList cmdLineParams;
-    cmdLineParams.tokenize(commandline, ",");
+    snprintf(line, sizeof(line), "Mine performance over the last %.0f seconds with %d mines on the field",
+             bz_getCurrentTime() - perfStats.since, getMineCount());
+    lines.push_back(line);
 
-    if (cmdLineParams.size() >= 1)
+    snprintf(line, sizeof(line), "%-16s %9s %9s %9s %9s %9s %9s", "event", "calls", "avg us", "p50 us", "p90 us", "p99 us", "max us");
+    lines.push_back(line);
+
+    for (int i = 0; i < (int)PerfStats::Section::Count; i++)
     {
-        deathMessagesFile = parsePath(cmdLineParams.get(0));
+        PerfStats::Section section = (PerfStats::Section)i;
+        const PerfStats::Histogram &histogram = perfStats.get(section);
+
+        if (histogram.calls == 0)
+        {
+            continue;
+        }
+
+        snprintf(line, sizeof(line), "%-16s %9llu %9.2f %9.2f %9.2f %9.2f %9.2f", PerfStats::sectionName(section),
+                 histogram.calls, histogram.totalNs / 1000.0 / histogram.calls, histogram.percentile(0.5) / 1000.0,
+                 histogram.percentile(0.9) / 1000.0, histogram.percentile(0.99) / 1000.0, histogram.maxNs / 1000.0);
+        lines.push_back(line);
     }
 
-    if (cmdLineParams.size() >= 2)
+    for (int i = 0; i < (int)PerfStats::Counter::Count; i++)
     {
-        defusalMessagesFile = parsePath(cmdLineParams.get(1));
+        snprintf(line, sizeof(line), "%-16s %9llu", PerfStats::counterName((PerfStats::Counter)i), perfStats.counters[i]);
+        lines.push_back(line);
     }
-}
 
-std::string UselessMine::parsePath(bz_ApiString path)
-{
-    std::string lower = bz_tolower(path.c_str());
+    unsigned long long updates = perfStats.counters[(int)PerfStats::Counter::UpdatesChecked];
 
-    if (lower == "null")
+    if (updates > 0)
     {
-        return "";
+        snprintf(line, sizeof(line), "%.2f mines scanned and %.2f candidate hits per update checked",
+                 (double)perfStats.counters[(int)PerfStats::Counter::MinesScanned] / updates,
+                 (double)perfStats.counters[(int)PerfStats::Counter::CandidateHits] / updates);
+        lines.push_back(line);
     }
-
-    return path;
 }
 
-// Reload the death messages
-void UselessMine::reloadDeathMessages()
+// Send the performance statistics to a player
+void UselessMine::sendPerfStats(int playerID)
 {
-    deathMessages.clear();
+#ifndef USELESSMINE_DISABLE_PERF
+    std::vector<std::string> lines;
+    formatPerfStats(lines);
 
-    if (!deathMessagesFile.empty())
+    for (const std::string &line : lines)
     {
-        deathMessages = getFileTextLines(deathMessagesFile);
+        bz_sendTextMessage(BZ_SERVER, playerID, line.c_str());
     }
+#else
+    bz_sendTextMessage(BZ_SERVER, playerID, "Mine performance statistics were disabled when this plug-in was compiled");
+#endif
 }
 
-// Reload the defusal messages
-void UselessMine::reloadDefusalMessages()
+// Append the performance statistics to _minePerfLogFile
+void UselessMine::writePerfLog()
 {
-    defusalMessages.clear();
+#ifndef USELESSMINE_DISABLE_PERF
+    FILE *file = fopen(settings.perfLogFile.c_str(), "a");
 
-    if (!defusalMessagesFile.empty())
+    if (!file)
     {
-        defusalMessages = getFileTextLines(defusalMessagesFile);
+        bz_debugMessagef(2, "WARNING :: Useless Mine :: Could not open %s to write performance statistics", settings.perfLogFile.c_str());
+        return;
+    }
+
+    std::vector<std::string> lines;
+    formatPerfStats(lines);
+
+    fprintf(file, "[%.3f]\n", bz_getCurrentTime());
+
+    for (const std::string &line : lines)
+    {
+        fprintf(file, "%s\n", line.c_str());
     }
+
+    fprintf(file, "\n");
+    fclose(file);
+#endif
 }
 
-// Get the amount of active mines that exist
-int UselessMine::getMineCount()
+// Open _mineAnalyticsFile, or stop logging if it was cleared
+void UselessMine::startAnalytics()
 {
-    int count = 0;
+    analytics.stop();
+
+    if (settings.analyticsFile.empty())
+    {
+        return;
+    }
+
+    if (!analytics.start(settings.analyticsFile, bz_getCurrentTime(), (float)bz_getBZDBDouble(bzdb_worldSize)))
+    {
+        bz_debugMessagef(2, "WARNING :: Useless Mine :: Could not open %s to log mine activity; it may be from an incompatible version of the plug-in",
+                         settings.analyticsFile.c_str());
+        return;
+    }
 
-    for (Mine &m : activeMines)
+    // Start the session with everyone already on the server so their mines can be tied to a callsign
+    for (int playerID = 0; playerID < CallsignTable::MAX_PLAYERS; playerID++)
     {
-        if (!m.isStale())
+        if (callsigns.get(playerID))
         {
-            count++;
+            recordPlayer(playerID);
         }
     }
-
-    return count;
 }
 
-// Remove a specific mine
-void UselessMine::removeMine(Mine &mine)
+void UselessMine::recordPlayer(int playerID)
 {
-    const char* uid = mine.uid.c_str();
+    const char* callsign = callsigns.get(playerID);
 
-    bz_debugMessagef(DEBUG_VERBOSITY, "DEBUG :: Useless Mine :: Removing mine UID: %s", mine.uid.c_str());
-    bz_debugMessagef(DEBUG_VERBOSITY, "DEBUG :: Useless Mine ::   mine count: %d", getMineCount());
+    if (!analytics.isRunning() || !callsign)
+    {
+        return;
+    }
 
-    activeMines.erase(
-        std::remove_if(
-            activeMines.begin(),
-            activeMines.end(),
-            [uid](Mine &m) {
-                bool result = (m.uid == uid);
+    AnalyticsLog::PlayerRecord record = {};
+    record.time = bz_getCurrentTime();
+    record.playerID = (int16_t)playerID;
+    record.team = (uint8_t)playerStates[playerID].team;
+    record.length = (uint8_t)std::min(strlen(callsign), (size_t)32);
 
-                if (result)
-                {
-                    bz_debugMessagef(DEBUG_VERBOSITY, "DEBUG :: Useless Mine :: Mine %s removed", uid);
-                }
+    analytics.record(AnalyticsLog::RecordType::Player, record, callsign, record.length);
+}
 
-                return result;
-            }
-        ),
-        activeMines.end()
-    );
+void UselessMine::recordMineRemoved(MineHandle mine, AnalyticsLog::RemoveReason reason)
+{
+    if (!analytics.isRunning() || !activeMines.isValid(mine))
+    {
+        return;
+    }
 
-    bz_debugMessagef(DEBUG_VERBOSITY, "DEBUG :: Useless Mine ::   new mine count: %d", getMineCount());
+    AnalyticsLog::RemovedRecord record = {};
+    record.time = bz_getCurrentTime();
+    record.mine = activeMines.seq[activeMines.indexOf(mine)];
+    record.reason = (uint8_t)reason;
+
+    analytics.record(AnalyticsLog::RecordType::MineRemoved, record);
 }
 
-// Remove all of the mines of a specific player
-void UselessMine::removePlayerMines(int playerID)
+void UselessMine::recordMineTriggered(AnalyticsLog::RecordType type, MineHandle mine, uint32_t shotGUID, int triggeredBy)
 {
-    bz_debugMessagef(DEBUG_VERBOSITY, "DEBUG :: Useless Mine :: Removing all mines for player %d", playerID);
+    if (!analytics.isRunning())
+    {
+        return;
+    }
 
-    activeMines.erase(
-        std::remove_if(
-            activeMines.begin(),
-            activeMines.end(),
-            [playerID](Mine &m) { return m.owner == playerID; }
-        ),
-        activeMines.end()
-    );
+    unsigned int i = activeMines.indexOf(mine);
+
+    AnalyticsLog::TriggeredRecord record = {};
+    record.time = bz_getCurrentTime();
+    record.pos[0] = activeMines.x[i];
+    record.pos[1] = activeMines.y[i];
+    record.pos[2] = activeMines.z[i];
+    record.mine = activeMines.seq[i];
+    record.shot = shotGUID;
+    record.owner = (int16_t)activeMines.owner[i];
+    record.triggeredBy = (int16_t)triggeredBy;
+
+    analytics.record(type, record);
 }
 
-// A shortcut to set a mine
-void UselessMine::setMine(int owner, float pos[3], bz_eTeamType team)
+// Send the contents of the trace log to a player, oldest entries first
+void UselessMine::sendTraceLog(int playerID)
 {
-    // Remove their flag because they "converted" it into a mine
-    bz_removePlayerFlag(owner);
-
-    Mine newMine(owner, pos, team);
+#ifndef USELESSMINE_DISABLE_TRACE
+    if (traceLog.size() == 0)
+    {
+        bz_sendTextMessage(BZ_SERVER, playerID, "The mine trace log is empty");
+        return;
+    }
 
-    bz_debugMessagef(DEBUG_VERBOSITY, "DEBUG :: Useless Mine :: Mine UID %s created by %d", newMine.uid.c_str(), owner);
-    bz_debugMessagef(DEBUG_VERBOSITY, "DEBUG :: Useless Mine ::   x, y, z => %0.2f, %0.2f, %0.2f", pos[0], pos[1], pos[2]);
+    for (unsigned int i = 0; i < traceLog.size(); i++)
+    {
+        const TraceLog::Entry &entry = traceLog.get(i);
 
-    activeMines.push_back(newMine);
+        bz_sendTextMessagef(BZ_SERVER, playerID, "%.3f player %d mine %u %s at {%0.2f, %0.2f, %0.2f}",
+                            entry.time, entry.playerID, entry.mineID, TraceLog::typeName(entry.type),
+                            entry.pos[0], entry.pos[1], entry.pos[2]);
+    }
+#else
+    bz_sendTextMessage(BZ_SERVER, playerID, "The mine trace log was disabled when this plug-in was compiled");
+#endif
 }
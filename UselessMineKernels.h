@@ -0,0 +1,188 @@
+/*
+    Copyright (C) 2013-2018 Vladimir "allejo" Jimenez
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the “Software”), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// The proximity kernels that filter a block of packed mines down to the ones a player could possibly trigger. They
+// only depend on the standard library and the compiler's intrinsics, so they can be tested on their own.
+
+#pragma once
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define USELESSMINE_SSE2
+    #include <emmintrin.h>
+
+    // GCC and Clang can compile AVX2 functions without requiring AVX2 for the rest of the plug-in
+    #if defined(__GNUC__) || defined(__clang__)
+        #define USELESSMINE_AVX2
+        #include <immintrin.h>
+    #endif
+#endif
+
+// The bounds a mine has to be in, and the owner and team rules it has to pass, for a player to possibly trigger it.
+// The bounds are a little larger than the trigger boxes so this rough float test never misses a mine that the exact
+// test would catch.
+struct ProximityQuery
+{
+    float min[3];
+    float max[3];
+    int playerID;
+    int team;
+    bool anyTeam;          // True if mines of the player's own team can be triggered as well
+};
+
+// Find the mines in a block of packed mine data that pass a ProximityQuery; the index of every mine found is written to
+// `hits` and the number of mines found is returned
+typedef unsigned int (*ProximityKernel)(const float *x, const float *y, const float *z, const int *owner, const int *team,
+                                        unsigned int count, const ProximityQuery &query, unsigned int *hits);
+
+inline unsigned int findNearbyMinesScalar(const float *x, const float *y, const float *z, const int *owner, const int *team,
+                                          unsigned int count, const ProximityQuery &query, unsigned int *hits)
+{
+    unsigned int found = 0;
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (x[i] > query.min[0] && x[i] < query.max[0] &&
+            y[i] > query.min[1] && y[i] < query.max[1] &&
+            z[i] > query.min[2] && z[i] < query.max[2] &&
+            owner[i] != query.playerID && (query.anyTeam || team[i] != query.team))
+        {
+            hits[found++] = i;
+        }
+    }
+
+    return found;
+}
+
+#ifdef USELESSMINE_SSE2
+inline unsigned int findNearbyMinesSSE2(const float *x, const float *y, const float *z, const int *owner, const int *team,
+                                        unsigned int count, const ProximityQuery &query, unsigned int *hits)
+{
+    const __m128 minX = _mm_set1_ps(query.min[0]), maxX = _mm_set1_ps(query.max[0]);
+    const __m128 minY = _mm_set1_ps(query.min[1]), maxY = _mm_set1_ps(query.max[1]);
+    const __m128 minZ = _mm_set1_ps(query.min[2]), maxZ = _mm_set1_ps(query.max[2]);
+    const __m128i playerID = _mm_set1_epi32(query.playerID);
+    const __m128i playerTeam = _mm_set1_epi32(query.team);
+    const __m128i anyTeam = _mm_set1_epi32(query.anyTeam ? -1 : 0);
+
+    unsigned int found = 0;
+    unsigned int i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 vx = _mm_loadu_ps(x + i), vy = _mm_loadu_ps(y + i), vz = _mm_loadu_ps(z + i);
+        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(vx, minX), _mm_cmplt_ps(vx, maxX)),
+                                   _mm_and_ps(_mm_cmpgt_ps(vy, minY), _mm_cmplt_ps(vy, maxY)));
+        inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpgt_ps(vz, minZ), _mm_cmplt_ps(vz, maxZ)));
+
+        __m128i ownMine = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(owner + i)), playerID);
+        __m128i sameTeam = _mm_andnot_si128(anyTeam, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(team + i)), playerTeam));
+        __m128i ineligible = _mm_or_si128(ownMine, sameTeam);
+
+        int mask = _mm_movemask_ps(_mm_andnot_ps(_mm_castsi128_ps(ineligible), inside));
+
+        for (int lane = 0; mask != 0; lane++, mask >>= 1)
+        {
+            if (mask & 1)
+            {
+                hits[found++] = i + lane;
+            }
+        }
+    }
+
+    unsigned int rest = findNearbyMinesScalar(x + i, y + i, z + i, owner + i, team + i, count - i, query, hits + found);
+
+    for (unsigned int j = found; j < found + rest; j++)
+    {
+        hits[j] += i;
+    }
+
+    return found + rest;
+}
+#endif
+
+#ifdef USELESSMINE_AVX2
+__attribute__((target("avx2")))
+inline unsigned int findNearbyMinesAVX2(const float *x, const float *y, const float *z, const int *owner, const int *team,
+                                        unsigned int count, const ProximityQuery &query, unsigned int *hits)
+{
+    const __m256 minX = _mm256_set1_ps(query.min[0]), maxX = _mm256_set1_ps(query.max[0]);
+    const __m256 minY = _mm256_set1_ps(query.min[1]), maxY = _mm256_set1_ps(query.max[1]);
+    const __m256 minZ = _mm256_set1_ps(query.min[2]), maxZ = _mm256_set1_ps(query.max[2]);
+    const __m256i playerID = _mm256_set1_epi32(query.playerID);
+    const __m256i playerTeam = _mm256_set1_epi32(query.team);
+    const __m256i anyTeam = _mm256_set1_epi32(query.anyTeam ? -1 : 0);
+
+    unsigned int found = 0;
+    unsigned int i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 vx = _mm256_loadu_ps(x + i), vy = _mm256_loadu_ps(y + i), vz = _mm256_loadu_ps(z + i);
+        __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(vx, minX, _CMP_GT_OQ), _mm256_cmp_ps(vx, maxX, _CMP_LT_OQ)),
+                                      _mm256_and_ps(_mm256_cmp_ps(vy, minY, _CMP_GT_OQ), _mm256_cmp_ps(vy, maxY, _CMP_LT_OQ)));
+        inside = _mm256_and_ps(inside, _mm256_and_ps(_mm256_cmp_ps(vz, minZ, _CMP_GT_OQ), _mm256_cmp_ps(vz, maxZ, _CMP_LT_OQ)));
+
+        __m256i ownMine = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(owner + i)), playerID);
+        __m256i sameTeam = _mm256_andnot_si256(anyTeam, _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(team + i)), playerTeam));
+        __m256i ineligible = _mm256_or_si256(ownMine, sameTeam);
+
+        int mask = _mm256_movemask_ps(_mm256_andnot_ps(_mm256_castsi256_ps(ineligible), inside));
+
+        for (int lane = 0; mask != 0; lane++, mask >>= 1)
+        {
+            if (mask & 1)
+            {
+                hits[found++] = i + lane;
+            }
+        }
+    }
+
+    unsigned int rest = findNearbyMinesScalar(x + i, y + i, z + i, owner + i, team + i, count - i, query, hits + found);
+
+    for (unsigned int j = found; j < found + rest; j++)
+    {
+        hits[j] += i;
+    }
+
+    return found + rest;
+}
+#endif
+
+// Pick the fastest proximity kernel the server's CPU supports
+inline ProximityKernel selectProximityKernel(const char* &name)
+{
+#ifdef USELESSMINE_AVX2
+    if (__builtin_cpu_supports("avx2"))
+    {
+        name = "AVX2";
+        return findNearbyMinesAVX2;
+    }
+#endif
+
+#ifdef USELESSMINE_SSE2
+    name = "SSE2";
+    return findNearbyMinesSSE2;
+#else
+    name = "scalar";
+    return findNearbyMinesScalar;
+#endif
+}
@@ -0,0 +1,526 @@
+/*
+    Copyright (C) 2013-2018 Vladimir "allejo" Jimenez
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the “Software”), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// A stand-alone tool that reads the files written by _mineAnalyticsFile and prints a heatmap of where mines were laid
+// and set off for each file, followed by a summary of every player across all of the files. Servers are expected to use
+// a separate file for each map so each heatmap covers a single map.
+//
+//   c++ -std=c++11 -o UselessMineLogReader UselessMineLogReader.cpp
+//   ./UselessMineLogReader [-cells N] file...
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// These definitions must be kept in sync with UselessMine::AnalyticsLog
+namespace AnalyticsLog
+{
+    const uint32_t MAGIC = 0x4C414D55; // "UMAL"
+    const uint32_t VERSION = 1;
+
+    enum class RecordType : uint8_t
+    {
+        Session = 1,
+        Player,
+        MinePlaced,
+        MineDetonated,
+        MineDefused,
+        MineRemoved,
+        Kills
+    };
+
+    enum class ExplosionType : uint8_t
+    {
+        Mine = 0,
+        Defusal
+    };
+
+    enum class RemoveReason : uint8_t
+    {
+        Expired = 0,
+        Replaced,
+        OwnerLeft
+    };
+
+    struct SessionRecord
+    {
+        int64_t startedAt;
+        double time;
+        float worldSize;
+        uint8_t unused[4];
+    };
+
+    struct PlayerRecord
+    {
+        double time;
+        int16_t playerID;
+        uint8_t team;
+        uint8_t length;
+        uint8_t unused[4];
+    };
+
+    struct PlacedRecord
+    {
+        double time;
+        float pos[3];
+        uint32_t mine;
+        int16_t owner;
+        uint8_t team;
+        uint8_t unused[5];
+    };
+
+    struct TriggeredRecord
+    {
+        double time;
+        float pos[3];
+        uint32_t mine;
+        uint32_t shot;
+        int16_t owner;
+        int16_t triggeredBy;
+    };
+
+    struct RemovedRecord
+    {
+        double time;
+        uint32_t mine;
+        uint8_t reason;
+        uint8_t unused[3];
+    };
+
+    struct KillsRecord
+    {
+        double time;
+        uint32_t shot;
+        int16_t shotOwner;
+        int16_t mineOwner;
+        uint8_t type;
+        uint8_t ownerKilled;
+        uint8_t victims;
+        uint8_t unused[5];
+    };
+}
+
+// Everything known about a single callsign across all of the files
+struct PlayerSummary
+{
+    PlayerSummary() :
+        placed(0),
+        detonated(0),
+        defused(0),
+        defusedByOthers(0),
+        expired(0),
+        kills(0),
+        selfKills(0),
+        deaths(0),
+        triggerTime(0),
+        triggered(0)
+    {
+    }
+
+    unsigned int placed;          // Mines laid
+    unsigned int detonated;       // Mines of theirs that someone drove into
+    unsigned int defused;         // Mines they defused
+    unsigned int defusedByOthers; // Mines of theirs that someone defused
+    unsigned int expired;         // Mines of theirs that reached the end of _mineLifetime
+    unsigned int kills;           // Other players killed by their mines or by mines they defused
+    unsigned int selfKills;       // Times they were killed by their own mine or a mine they defused
+    unsigned int deaths;          // Times they were killed by a mine someone else laid or defused
+    double triggerTime;           // The total seconds between laying a mine and it being set off
+    unsigned int triggered;
+};
+
+// A count of events in each cell of a grid laid over the map
+struct Heatmap
+{
+    Heatmap(int _cells, float _worldSize) :
+        cells(_cells),
+        worldSize(_worldSize),
+        counts(_cells * _cells, 0)
+    {
+    }
+
+    void add(const float pos[3])
+    {
+        int x = (int)((pos[0] + worldSize / 2) / worldSize * cells);
+        int y = (int)((pos[1] + worldSize / 2) / worldSize * cells);
+
+        counts[std::max(0, std::min(cells - 1, y)) * cells + std::max(0, std::min(cells - 1, x))]++;
+    }
+
+    // Print the grid with north at the top, using a brighter character for busier cells
+    void print(const char* title) const
+    {
+        static const char shades[] = " .:-=+*#%@";
+        unsigned int busiest = *std::max_element(counts.begin(), counts.end());
+        unsigned int total = 0;
+
+        for (unsigned int count : counts)
+        {
+            total += count;
+        }
+
+        printf("  %s (%u total, busiest cell %u)\n", title, total, busiest);
+        printf("  +%s+\n", std::string(cells, '-').c_str());
+
+        for (int y = cells - 1; y >= 0; y--)
+        {
+            std::string row;
+
+            for (int x = 0; x < cells; x++)
+            {
+                unsigned int count = counts[y * cells + x];
+                size_t shade = (count == 0) ? 0 : 1 + (count - 1) * (sizeof(shades) - 3) / std::max(1u, busiest - 1);
+
+                row += shades[std::min(shade, sizeof(shades) - 2)];
+            }
+
+            printf("  |%s|\n", row.c_str());
+        }
+
+        printf("  +%s+\n", std::string(cells, '-').c_str());
+    }
+
+    int cells;
+    float worldSize;
+    std::vector<unsigned int> counts;
+};
+
+// The mines on the field during a single session of the plug-in, since mine and player IDs only mean something inside
+// of the session they were written in
+struct Session
+{
+    struct Mine
+    {
+        double placedAt;
+        std::string owner;
+    };
+
+    std::string callsigns[256];
+    std::unordered_map<uint32_t, Mine> mines;
+
+    std::string callsign(int playerID) const
+    {
+        if (playerID < 0 || playerID > 255 || callsigns[playerID].empty())
+        {
+            return "#" + std::to_string(playerID);
+        }
+
+        return callsigns[playerID];
+    }
+};
+
+std::map<std::string, PlayerSummary> players;
+int cells = 20;
+
+template <typename T>
+bool readPayload(const char* payload, size_t size, T &record)
+{
+    if (size < sizeof(T))
+    {
+        return false;
+    }
+
+    memcpy(&record, payload, sizeof(T));
+
+    return true;
+}
+
+// Read a single file, adding what happened in it to the player summaries and printing its heatmaps
+bool readLog(const char* path)
+{
+    using namespace AnalyticsLog;
+
+    FILE *file = fopen(path, "rb");
+
+    if (!file)
+    {
+        fprintf(stderr, "%s: could not be opened\n", path);
+        return false;
+    }
+
+    uint32_t header[2];
+
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) || header[0] != MAGIC || header[1] != VERSION)
+    {
+        fprintf(stderr, "%s: not a mine analytics log or written by an unsupported version\n", path);
+        fclose(file);
+        return false;
+    }
+
+    float worldSize = 800;
+    Heatmap *placements = nullptr;
+    Heatmap *detonations = nullptr;
+    Session session;
+    unsigned int sessions = 0;
+    unsigned int victims = 0;
+    unsigned int explosions = 0;
+    bool truncated = false;
+
+    uint8_t type, size;
+    char payload[256];
+
+    while (fread(&type, 1, 1, file) == 1)
+    {
+        if (fread(&size, 1, 1, file) != 1 || fread(payload, 1, size, file) != size)
+        {
+            truncated = true;
+            break;
+        }
+
+        switch ((RecordType)type)
+        {
+            case RecordType::Session:
+            {
+                SessionRecord record;
+
+                if (readPayload(payload, size, record))
+                {
+                    session = Session();
+                    sessions++;
+
+                    if (!placements && record.worldSize > 0)
+                    {
+                        worldSize = record.worldSize;
+                    }
+                }
+            }
+            break;
+
+            case RecordType::Player:
+            {
+                PlayerRecord record;
+
+                if (readPayload(payload, size, record) && record.playerID >= 0 && record.playerID < 256)
+                {
+                    size_t length = std::min((size_t)record.length, size - sizeof(record));
+                    session.callsigns[record.playerID] = std::string(payload + sizeof(record), length);
+                }
+            }
+            break;
+
+            case RecordType::MinePlaced:
+            {
+                PlacedRecord record;
+
+                if (readPayload(payload, size, record))
+                {
+                    if (!placements)
+                    {
+                        placements = new Heatmap(cells, worldSize);
+                        detonations = new Heatmap(cells, worldSize);
+                    }
+
+                    std::string owner = session.callsign(record.owner);
+
+                    session.mines[record.mine] = {record.time, owner};
+                    players[owner].placed++;
+                    placements->add(record.pos);
+                }
+            }
+            break;
+
+            case RecordType::MineDetonated:
+            case RecordType::MineDefused:
+            {
+                TriggeredRecord record;
+
+                if (readPayload(payload, size, record))
+                {
+                    std::string owner = session.callsign(record.owner);
+                    auto mine = session.mines.find(record.mine);
+
+                    if (mine != session.mines.end())
+                    {
+                        players[owner].triggerTime += record.time - mine->second.placedAt;
+                        players[owner].triggered++;
+                        session.mines.erase(mine);
+                    }
+
+                    if ((RecordType)type == RecordType::MineDefused)
+                    {
+                        players[session.callsign(record.triggeredBy)].defused++;
+                        players[owner].defusedByOthers++;
+                    }
+                    else
+                    {
+                        players[owner].detonated++;
+                    }
+
+                    if (detonations)
+                    {
+                        detonations->add(record.pos);
+                    }
+                }
+            }
+            break;
+
+            case RecordType::MineRemoved:
+            {
+                RemovedRecord record;
+
+                if (readPayload(payload, size, record))
+                {
+                    auto mine = session.mines.find(record.mine);
+
+                    if (mine != session.mines.end())
+                    {
+                        if (record.reason == (uint8_t)RemoveReason::Expired)
+                        {
+                            players[mine->second.owner].expired++;
+                        }
+
+                        session.mines.erase(mine);
+                    }
+                }
+            }
+            break;
+
+            case RecordType::Kills:
+            {
+                KillsRecord record;
+
+                if (readPayload(payload, size, record))
+                {
+                    // A defused mine goes off at its owner, and its kills belong to the player who defused it
+                    int killerID = ((ExplosionType)record.type == ExplosionType::Defusal) ? record.shotOwner : record.mineOwner;
+                    std::vector<int> victimIDs;
+
+                    for (size_t i = 0; i < std::min((size_t)record.victims, size - sizeof(record)); i++)
+                    {
+                        victimIDs.push_back((uint8_t)payload[sizeof(record) + i]);
+                    }
+
+                    if (record.ownerKilled)
+                    {
+                        victimIDs.push_back(record.mineOwner);
+                    }
+
+                    PlayerSummary &killer = players[session.callsign(killerID)];
+
+                    for (int victimID : victimIDs)
+                    {
+                        if (victimID == killerID)
+                        {
+                            killer.selfKills++;
+                        }
+                        else
+                        {
+                            players[session.callsign(victimID)].deaths++;
+                            killer.kills++;
+                        }
+                    }
+
+                    victims += victimIDs.size();
+                    explosions++;
+                }
+            }
+            break;
+
+            default:
+                // Records from a newer minor revision of the format are skipped since their size is always known
+                break;
+        }
+    }
+
+    fclose(file);
+
+    printf("%s: %u session(s)", path, sessions);
+
+    if (explosions > 0)
+    {
+        printf(", %.2f victims per explosion", (double)victims / explosions);
+    }
+
+    printf("%s\n", truncated ? ", last record truncated" : "");
+
+    if (placements)
+    {
+        placements->print("Mines laid");
+        detonations->print("Mines set off");
+    }
+
+    printf("\n");
+
+    delete placements;
+    delete detonations;
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<const char*> paths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-cells") == 0 && i + 1 < argc)
+        {
+            cells = std::max(1, std::min(200, atoi(argv[++i])));
+        }
+        else
+        {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    if (paths.empty())
+    {
+        fprintf(stderr, "usage: %s [-cells N] file...\n", argv[0]);
+        return 1;
+    }
+
+    bool success = true;
+
+    for (const char* path : paths)
+    {
+        success = readLog(path) && success;
+    }
+
+    printf("%-32s %6s %6s %6s %6s %6s %6s %6s %6s %10s\n",
+           "Callsign", "Laid", "Hit", "Defuse", "Lost", "Expire", "Kills", "Self", "Deaths", "Avg. Life");
+
+    for (const auto &player : players)
+    {
+        const PlayerSummary &summary = player.second;
+
+        printf("%-32s %6u %6u %6u %6u %6u %6u %6u %6u",
+               player.first.c_str(), summary.placed, summary.detonated, summary.defused, summary.defusedByOthers,
+               summary.expired, summary.kills, summary.selfKills, summary.deaths);
+
+        if (summary.triggered > 0)
+        {
+            printf(" %9.1fs\n", summary.triggerTime / summary.triggered);
+        }
+        else
+        {
+            printf(" %10s\n", "-");
+        }
+    }
+
+    return success ? 0 : 1;
+}
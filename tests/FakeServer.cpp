@@ -0,0 +1,606 @@
+/*
+    Copyright (C) 2013-2018 Vladimir "allejo" Jimenez
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the “Software”), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <set>
+
+#include "FakeServer.h"
+#include "plugin_files.h"
+
+extern "C" bz_Plugin* bz_GetPlugin(void);
+extern "C" void bz_FreePlugin(bz_Plugin* plugin);
+
+namespace FakeServer
+{
+    // The server variables the plug-in reads start at BZFlag's defaults
+    std::map<std::string, std::string> bzdb = {
+        {"_shockOutRadius", "60"},
+        {"_tankSpeed", "25"},
+        {"_velocityAd", "1.5"},
+        {"_worldSize", "800"}
+    };
+    std::map<int, bz_BasePlayerRecord> players;
+    std::vector<Shot> shots;
+    double currentTime = 1000;
+    bz_eGameType gameType = eTeamFFAGame;
+    int debugLevel = 0;
+    bool printMessages = false;
+    unsigned long long messageCount = 0;
+    bool recordMessages = false;
+    std::vector<std::string> messages;
+
+    static bz_Plugin* plugin = nullptr;
+    static std::map<std::string, bz_CustomSlashCommandHandler*> commands;
+    static std::map<std::pair<uint32_t, std::string>, uint32_t> shotMetaData;
+    static std::set<bz_eEventType> registeredEvents;
+
+    // Like bzfs, only pass the plug-in the events it registered for
+    static void send(bz_EventData &eventData)
+    {
+        if (registeredEvents.count(eventData.eventType))
+        {
+            plugin->Event(&eventData);
+        }
+    }
+
+    bz_Plugin* load(const char* config)
+    {
+        shots.clear();
+        shotMetaData.clear();
+        messageCount = 0;
+        messages.clear();
+
+        plugin = bz_GetPlugin();
+        plugin->Init(config);
+
+        bz_WorldFinalizedEventData_V1 worldData;
+        send(worldData);
+
+        return plugin;
+    }
+
+    void unload()
+    {
+        if (!plugin)
+        {
+            return;
+        }
+
+        plugin->Cleanup();
+        bz_FreePlugin(plugin);
+        plugin = nullptr;
+    }
+
+    void set(const std::string &variable, const std::string &value)
+    {
+        bzdb[variable] = value;
+
+        bz_BZDBChangeData_V1 changeData;
+        changeData.key = variable;
+        changeData.value = value;
+        send(changeData);
+    }
+
+    void join(int playerID, bz_eTeamType team, const std::string &callsign)
+    {
+        bz_BasePlayerRecord &record = players[playerID];
+        record = bz_BasePlayerRecord();
+        record.playerID = playerID;
+        record.callsign = callsign;
+        record.team = team;
+        record.currentFlagID = -1;
+        record.spawned = false;
+
+        bz_PlayerJoinPartEventData_V1 joinData(bz_ePlayerJoinEvent);
+        joinData.playerID = playerID;
+        joinData.record = &record;
+        send(joinData);
+    }
+
+    void part(int playerID)
+    {
+        bz_PlayerJoinPartEventData_V1 partData(bz_ePlayerPartEvent);
+        partData.playerID = playerID;
+        partData.record = &players[playerID];
+        send(partData);
+
+        players.erase(playerID);
+    }
+
+    void spawn(int playerID, const float pos[3])
+    {
+        bz_BasePlayerRecord &record = players[playerID];
+        record.spawned = true;
+        record.currentFlag = "";
+        record.currentFlagID = -1;
+        std::copy(pos, pos + 3, record.lastKnownState.pos);
+
+        bz_PlayerSpawnEventData_V1 spawnData;
+        spawnData.playerID = playerID;
+        spawnData.team = record.team;
+        spawnData.state = record.lastKnownState;
+        send(spawnData);
+    }
+
+    int die(int playerID, int killerID, int shotID)
+    {
+        bz_BasePlayerRecord &record = players[playerID];
+        record.spawned = false;
+        record.currentFlag = "";
+        record.currentFlagID = -1;
+
+        bz_PlayerDieEventData_V1 dieData;
+        dieData.playerID = playerID;
+        dieData.team = record.team;
+        dieData.killerID = killerID;
+        dieData.shotID = shotID;
+        dieData.state = record.lastKnownState;
+        send(dieData);
+
+        return dieData.killerID;
+    }
+
+    void move(int playerID, const float pos[3])
+    {
+        bz_BasePlayerRecord &record = players[playerID];
+
+        bz_PlayerUpdateEventData_V1 updateData;
+        updateData.playerID = playerID;
+        updateData.lastState = record.lastKnownState;
+        std::copy(pos, pos + 3, updateData.state.pos);
+        updateData.stateTime = currentTime;
+
+        record.lastKnownState = updateData.state;
+        record.lastUpdateTime = (float)currentTime;
+
+        send(updateData);
+    }
+
+    void grabFlag(int playerID, const char* flagType)
+    {
+        bz_BasePlayerRecord &record = players[playerID];
+
+        if (strcmp(flagType, "US") == 0)
+        {
+            record.currentFlag = "USeless (+US)";
+        }
+        else if (strcmp(flagType, "BD") == 0)
+        {
+            record.currentFlag = "Bomb Defusal (+BD)";
+        }
+        else
+        {
+            record.currentFlag = flagType;
+        }
+
+        bz_FlagGrabbedEventData_V1 grabData;
+        grabData.playerID = playerID;
+        grabData.flagType = flagType;
+        std::copy(record.lastKnownState.pos, record.lastKnownState.pos + 3, grabData.pos);
+        send(grabData);
+    }
+
+    void dropFlag(int playerID)
+    {
+        bz_BasePlayerRecord &record = players[playerID];
+        record.currentFlag = "";
+
+        bz_FlagDroppedEventData_V1 dropData;
+        dropData.playerID = playerID;
+        dropData.flagType = "";
+        std::copy(record.lastKnownState.pos, record.lastKnownState.pos + 3, dropData.pos);
+        send(dropData);
+    }
+
+    void transferFlag(int fromPlayerID, int toPlayerID)
+    {
+        bz_BasePlayerRecord &from = players[fromPlayerID], &to = players[toPlayerID];
+        std::string flag = from.currentFlag;
+
+        // Events only carry the flag's abbreviation, which is at the end of its name like "(+BD)"
+        size_t start = flag.rfind("(+");
+        std::string flagType = (start == std::string::npos) ? flag : flag.substr(start + 2, flag.size() - start - 3);
+
+        to.currentFlag = flag;
+        from.currentFlag = "";
+
+        bz_FlagTransferredEventData_V1 transferData;
+        transferData.fromPlayerID = fromPlayerID;
+        transferData.toPlayerID = toPlayerID;
+        transferData.flagType = flagType.c_str();
+        send(transferData);
+    }
+
+    void newRabbit(int playerID)
+    {
+        for (auto &player : players)
+        {
+            if (player.second.team == eRabbitTeam)
+            {
+                player.second.team = eHunterTeam;
+            }
+        }
+
+        players[playerID].team = eRabbitTeam;
+
+        bz_NewRabbitEventData_V1 rabbitData;
+        rabbitData.newRabbit = playerID;
+        send(rabbitData);
+    }
+
+    void endShot(uint32_t guid)
+    {
+        bz_ShotEndedEventData_V1 shotData;
+        shotData.playerID = BZ_SERVER;
+        shotData.shotID = (int)guid;
+        send(shotData);
+    }
+
+    void tick()
+    {
+        bz_TickEventData_V1 tickData;
+        send(tickData);
+    }
+
+    bool command(int playerID, const char* command, const char* params)
+    {
+        auto it = FakeServer::commands.find(command);
+
+        if (it == FakeServer::commands.end())
+        {
+            return false;
+        }
+
+        bz_APIStringList paramList;
+        paramList.tokenize(params, " ");
+
+        return it->second->SlashCommand(playerID, command, params, &paramList);
+    }
+}
+
+using namespace FakeServer;
+
+void bz_APIStringList::tokenize(const char* in, const char* delimiters, int /*maxTokens*/, bool /*useQuotes*/)
+{
+    items.clear();
+
+    std::string token;
+
+    for (const char* c = in; c && *c; c++)
+    {
+        if (strchr(delimiters, *c))
+        {
+            if (!token.empty())
+            {
+                items.push_back(token);
+            }
+
+            token.clear();
+        }
+        else
+        {
+            token += *c;
+        }
+    }
+
+    if (!token.empty())
+    {
+        items.push_back(token);
+    }
+}
+
+bool bz_Plugin::Register(bz_eEventType event)
+{
+    return FakeServer::registeredEvents.insert(event).second;
+}
+
+void bz_Plugin::Flush()
+{
+    FakeServer::registeredEvents.clear();
+}
+
+bool bz_registerCustomBZDBInt(const char* variable, int defaultValue, int, bool)
+{
+    bzdb.insert(std::make_pair(variable, std::to_string(defaultValue)));
+    return true;
+}
+
+bool bz_registerCustomBZDBDouble(const char* variable, double defaultValue, int, bool)
+{
+    bzdb.insert(std::make_pair(variable, std::to_string(defaultValue)));
+    return true;
+}
+
+bool bz_registerCustomBZDBBool(const char* variable, bool defaultValue, int, bool)
+{
+    bzdb.insert(std::make_pair(variable, defaultValue ? "1" : "0"));
+    return true;
+}
+
+bool bz_registerCustomBZDBString(const char* variable, const char* defaultValue, int, bool)
+{
+    bzdb.insert(std::make_pair(variable, defaultValue));
+    return true;
+}
+
+// Unlike a real server, removing a variable keeps its value so a test can reload the plug-in with the same settings
+bool bz_removeCustomBZDBVariable(const char* /*variable*/)
+{
+    return true;
+}
+
+int bz_getBZDBInt(const char* variable)
+{
+    return atoi(bzdb[variable].c_str());
+}
+
+double bz_getBZDBDouble(const char* variable)
+{
+    return atof(bzdb[variable].c_str());
+}
+
+bool bz_getBZDBBool(const char* variable)
+{
+    const std::string &value = bzdb[variable];
+
+    return value == "true" || atoi(value.c_str()) != 0;
+}
+
+bz_ApiString bz_getBZDBString(const char* variable)
+{
+    return bz_ApiString(bzdb[variable]);
+}
+
+bz_APIIntList* bz_newIntList()
+{
+    return new bz_APIIntList();
+}
+
+void bz_deleteIntList(bz_APIIntList* list)
+{
+    delete list;
+}
+
+bool bz_getPlayerIndexList(bz_APIIntList* playerList)
+{
+    playerList->clear();
+
+    for (auto &player : players)
+    {
+        playerList->push_back(player.first);
+    }
+
+    return true;
+}
+
+bz_BasePlayerRecord* bz_getPlayerByIndex(int index)
+{
+    auto it = players.find(index);
+
+    return (it == players.end()) ? nullptr : new bz_BasePlayerRecord(it->second);
+}
+
+bool bz_freePlayerRecord(bz_BasePlayerRecord* playerRecord)
+{
+    delete playerRecord;
+    return true;
+}
+
+bz_eTeamType bz_getPlayerTeam(int playerID)
+{
+    auto it = players.find(playerID);
+
+    return (it == players.end()) ? eNoTeam : it->second.team;
+}
+
+const char* bz_getPlayerCallsign(int playerID)
+{
+    auto it = players.find(playerID);
+
+    return (it == players.end()) ? nullptr : it->second.callsign.c_str();
+}
+
+bool bz_hasPerm(int /*playerID*/, const char* /*perm*/)
+{
+    return true;
+}
+
+bool bz_removePlayerFlag(int playerID)
+{
+    auto it = players.find(playerID);
+
+    if (it == players.end())
+    {
+        return false;
+    }
+
+    it->second.currentFlag = "";
+    it->second.currentFlagID = -1;
+
+    return true;
+}
+
+bool bz_RegisterCustomFlag(const char*, const char*, const char*, int, bz_eFlagQuality)
+{
+    return true;
+}
+
+// Server shots are numbered from 1 in the order they're fired, and a server shot's GUID is its shot ID
+uint32_t bz_fireServerShot(const char* /*shotType*/, float origin[3], float /*vector*/[3], bz_eTeamType color, int /*targetPlayerId*/)
+{
+    Shot shot;
+    shot.guid = (uint32_t)shots.size() + 1;
+    std::copy(origin, origin + 3, shot.pos);
+    shot.team = color;
+    shot.time = currentTime;
+    shots.push_back(shot);
+
+    return shot.guid;
+}
+
+uint32_t bz_getShotGUID(int fromPlayer, int shotID)
+{
+    return (fromPlayer == BZ_SERVER && shotID > 0) ? (uint32_t)shotID : 0;
+}
+
+bool bz_shotHasMetaData(uint32_t shotGUID, const char* name)
+{
+    return FakeServer::shotMetaData.count(std::make_pair(shotGUID, std::string(name))) > 0;
+}
+
+uint32_t bz_getShotMetaDataI(uint32_t shotGUID, const char* name)
+{
+    auto it = FakeServer::shotMetaData.find(std::make_pair(shotGUID, std::string(name)));
+
+    return (it == FakeServer::shotMetaData.end()) ? 0 : it->second;
+}
+
+bool bz_setShotMetaData(uint32_t shotGUID, const char* name, uint32_t value)
+{
+    FakeServer::shotMetaData[std::make_pair(shotGUID, std::string(name))] = value;
+    return true;
+}
+
+bool bz_registerCustomSlashCommand(const char* command, bz_CustomSlashCommandHandler* handler)
+{
+    FakeServer::commands[command] = handler;
+    return true;
+}
+
+bool bz_removeCustomSlashCommand(const char* command)
+{
+    FakeServer::commands.erase(command);
+    return true;
+}
+
+bool bz_sendTextMessage(int /*from*/, int to, const char* message)
+{
+    messageCount++;
+
+    if (recordMessages)
+    {
+        messages.push_back(message);
+    }
+
+    if (printMessages)
+    {
+        printf("[to %d] %s\n", to, message);
+    }
+
+    return true;
+}
+
+bool bz_sendTextMessagef(int from, int to, const char* fmt, ...)
+{
+    char message[1024];
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+
+    return bz_sendTextMessage(from, to, message);
+}
+
+void bz_debugMessage(int level, const char* message)
+{
+    if (printMessages && level <= debugLevel)
+    {
+        printf("[debug %d] %s\n", level, message);
+    }
+}
+
+void bz_debugMessagef(int level, const char* fmt, ...)
+{
+    char message[1024];
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+
+    bz_debugMessage(level, message);
+}
+
+int bz_getDebugLevel()
+{
+    return debugLevel;
+}
+
+double bz_getCurrentTime()
+{
+    return currentTime;
+}
+
+bz_eGameType bz_getGameType()
+{
+    return gameType;
+}
+
+const char* bz_format(const char* fmt, ...)
+{
+    static char buffer[1024];
+
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    va_end(args);
+
+    return buffer;
+}
+
+const char* bz_tolower(const char* val)
+{
+    static std::string buffer;
+
+    buffer = val ? val : "";
+
+    for (char &c : buffer)
+    {
+        c = (char)tolower((unsigned char)c);
+    }
+
+    return buffer.c_str();
+}
+
+std::vector<std::string> getFileTextLines(const std::string &file)
+{
+    std::vector<std::string> lines;
+    std::ifstream input(file);
+    std::string line;
+
+    while (std::getline(input, line))
+    {
+        if (!line.empty())
+        {
+            lines.push_back(line);
+        }
+    }
+
+    return lines;
+}
@@ -0,0 +1,87 @@
+/*
+    Copyright (C) 2013-2018 Vladimir "allejo" Jimenez
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the “Software”), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// The state behind the stand-in bzfsAPI, and helpers that change it and send the plug-in the events a real server
+// would. Only one plug-in can be loaded at a time, and everything is expected to happen on a single thread.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "bzfsAPI.h"
+
+namespace FakeServer
+{
+    // A shot fired with bz_fireServerShot()
+    struct Shot
+    {
+        uint32_t guid;
+        float pos[3];
+        bz_eTeamType team;
+        double time;
+    };
+
+    extern std::map<std::string, std::string> bzdb;      // Every BZDB variable by name
+    extern std::map<int, bz_BasePlayerRecord> players;   // Every player on the server by player ID
+    extern std::vector<Shot> shots;                      // Every server shot fired since the plug-in was loaded
+    extern double currentTime;                           // Returned by bz_getCurrentTime(); only moves when told to
+    extern bz_eGameType gameType;
+    extern int debugLevel;
+    extern bool printMessages;                           // Print text and debug messages instead of only counting them
+    extern unsigned long long messageCount;              // Text messages sent to players since the plug-in was loaded
+    extern bool recordMessages;                          // Keep every text message in `messages`
+    extern std::vector<std::string> messages;
+
+    // Load the plug-in with the given command line, or unload it
+    bz_Plugin* load(const char* config = "");
+    void unload();
+
+    // Set a BZDB variable and tell the plug-in it changed, as `/set` does
+    void set(const std::string &variable, const std::string &value);
+
+    void join(int playerID, bz_eTeamType team, const std::string &callsign);
+    void part(int playerID);
+    void spawn(int playerID, const float pos[3]);
+
+    // Kill a player with the given shot, returning the killer the plug-in credited the kill to
+    int die(int playerID, int killerID = BZ_SERVER, int shotID = -1);
+
+    void move(int playerID, const float pos[3]);
+    void grabFlag(int playerID, const char* flagType);
+    void dropFlag(int playerID);
+
+    // Move a player's flag to another player, as the Thief flag does
+    void transferFlag(int fromPlayerID, int toPlayerID);
+
+    // Make a player the rabbit, sending the previous rabbit back to the hunters, as rabbit chase does
+    void newRabbit(int playerID);
+
+    // Tell the plug-in a server shot ended, as bzfs does once a shock wave has faded
+    void endShot(uint32_t guid);
+
+    void tick();
+
+    // Run a slash command as the given player, with the parameters separated by spaces
+    bool command(int playerID, const char* command, const char* params = "");
+}
@@ -0,0 +1,183 @@
+/*
+    Copyright (C) 2013-2018 Vladimir "allejo" Jimenez
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the “Software”), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// Checks that everyone killed by one mine explosion is announced in a single message when their deaths arrive over
+// several server ticks, as they do on a real server where each client reports its own death. The announcement has to
+// wait for the explosion's shot to end, or for the announcement window to pass if the server never says it ended.
+//
+//   ./UselessMineAnnouncementTest
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "FakeServer.h"
+
+const char* MESSAGES_FILE = "UselessMineAnnouncementTest.deathMessages";
+const int OWNER = 0;
+const int VICTIMS[] = {1, 2, 3};
+
+// Lay a mine at the origin, set it off with the first victim, and return the explosion's shot
+static uint32_t explode()
+{
+    float origin[3] = {0, 0, 0};
+    float away[3] = {200, 200, 0};
+
+    FakeServer::spawn(OWNER, origin);
+    FakeServer::grabFlag(OWNER, "US");
+    FakeServer::command(OWNER, "mine");
+    FakeServer::move(OWNER, away);
+
+    for (int victimID : VICTIMS)
+    {
+        float pos[3] = {-100.0f - victimID * 20, 100, 0};
+        FakeServer::spawn(victimID, pos);
+    }
+
+    size_t shots = FakeServer::shots.size();
+    FakeServer::move(VICTIMS[0], origin);
+
+    return (FakeServer::shots.size() == shots + 1) ? FakeServer::shots.back().guid : 0;
+}
+
+// Kill every victim with the shot, ticking between the deaths
+static void killVictims(uint32_t guid)
+{
+    for (int victimID : VICTIMS)
+    {
+        FakeServer::die(victimID, BZ_SERVER, (int)guid);
+        FakeServer::currentTime += 0.05;
+        FakeServer::tick();
+    }
+}
+
+static int countAnnouncements()
+{
+    return (int)std::count_if(FakeServer::messages.begin(), FakeServer::messages.end(), [](const std::string &message) {
+        return message.find("drove over") != std::string::npos;
+    });
+}
+
+// Check that exactly one announcement was made, and that it names every victim
+static bool checkAnnouncement(const char* scenario)
+{
+    if (countAnnouncements() != 1)
+    {
+        printf("FAILED %s: expected one announcement, got %d\n", scenario, countAnnouncements());
+        return false;
+    }
+
+    const std::string &message = *std::find_if(FakeServer::messages.begin(), FakeServer::messages.end(), [](const std::string &message) {
+        return message.find("drove over") != std::string::npos;
+    });
+
+    if (message != "victim1, victim2 and victim3 drove over owner's mine")
+    {
+        printf("FAILED %s: announced \"%s\"\n", scenario, message.c_str());
+        return false;
+    }
+
+    printf("%s: \"%s\"\n", scenario, message.c_str());
+    return true;
+}
+
+static bool testShotEnded()
+{
+    uint32_t guid = explode();
+
+    if (!guid)
+    {
+        printf("FAILED shot ended: the mine didn't go off\n");
+        return false;
+    }
+
+    FakeServer::messages.clear();
+    killVictims(guid);
+
+    if (countAnnouncements() != 0)
+    {
+        printf("FAILED shot ended: the kills were announced before the shot ended\n");
+        return false;
+    }
+
+    FakeServer::endShot(guid);
+    FakeServer::tick();
+
+    return checkAnnouncement("shot ended");
+}
+
+static bool testWindowPassed()
+{
+    uint32_t guid = explode();
+
+    if (!guid)
+    {
+        printf("FAILED window passed: the mine didn't go off\n");
+        return false;
+    }
+
+    FakeServer::messages.clear();
+    killVictims(guid);
+
+    if (countAnnouncements() != 0)
+    {
+        printf("FAILED window passed: the kills were announced before the window passed\n");
+        return false;
+    }
+
+    FakeServer::currentTime += 2;
+    FakeServer::tick();
+
+    return checkAnnouncement("window passed");
+}
+
+int main()
+{
+    if (FILE* file = fopen(MESSAGES_FILE, "w"))
+    {
+        fputs("%victim% drove over %owner%'s mine\n", file);
+        fclose(file);
+    }
+    else
+    {
+        printf("FAILED: couldn't write %s\n", MESSAGES_FILE);
+        return 1;
+    }
+
+    FakeServer::bzdb["_mineSafetyTime"] = "0";
+    FakeServer::recordMessages = true;
+    FakeServer::load(MESSAGES_FILE);
+
+    FakeServer::join(OWNER, eRedTeam, "owner");
+
+    for (int victimID : VICTIMS)
+    {
+        FakeServer::join(victimID, eBlueTeam, "victim" + std::to_string(victimID));
+    }
+
+    bool passed = testShotEnded() && testWindowPassed();
+
+    FakeServer::unload();
+    remove(MESSAGES_FILE);
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,324 @@
+/*
+    Copyright (C) 2013-2018 Vladimir "allejo" Jimenez
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the “Software”), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// Measures how long the plug-in takes to handle each kind of event by feeding it a synthetic match through the
+// stand-in bzfsAPI. Players drive around a field of mines, lay new mines to keep the field at the requested size, die
+// and respawn. For each kind of event, the time and the number of heap allocations per event are reported along with
+// the number of events that could be handled each second.
+//
+//   ./UselessMineBenchmark [-players N] [-mines N] [-frames N] [-seed N] [variable=value...]
+//
+// Any variable=value argument sets a BZDB variable before the plug-in is loaded, e.g. _mineWorkerThread=1.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+
+#include "FakeServer.h"
+
+// Every allocation made by the process, including the ones made by the plug-in
+static std::atomic<unsigned long long> allocations(0);
+
+void* operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (void* memory = malloc(size ? size : 1))
+    {
+        return memory;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+class Benchmark
+{
+public:
+    enum class Stream
+    {
+        Update,
+        Tick,
+        Spawn,
+        Die,
+        MineCommand,
+        Count
+    };
+
+    // Time how long the plug-in takes to run `handle` for `events` events
+    template <typename Handler>
+    void measure(Stream stream, unsigned long long events, Handler handle)
+    {
+        Result &result = results[(int)stream];
+        unsigned long long allocationsBefore = allocations.load(std::memory_order_relaxed);
+        auto start = std::chrono::steady_clock::now();
+
+        handle();
+
+        auto end = std::chrono::steady_clock::now();
+        result.events += events;
+        result.ns += (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        result.allocations += allocations.load(std::memory_order_relaxed) - allocationsBefore;
+    }
+
+    void print() const
+    {
+        const char* names[] = {"player update", "tick", "spawn", "die", "/mine"};
+
+        printf("%-16s %12s %12s %14s %14s\n", "Event", "Events", "ns/event", "allocs/event", "events/s");
+
+        for (int i = 0; i < (int)Stream::Count; i++)
+        {
+            const Result &result = results[i];
+
+            if (result.events == 0)
+            {
+                continue;
+            }
+
+            double nsPerEvent = (double)result.ns / result.events;
+
+            printf("%-16s %12llu %12.1f %14.3f %14.0f\n", names[i], result.events, nsPerEvent,
+                   (double)result.allocations / result.events, (nsPerEvent > 0) ? 1e9 / nsPerEvent : 0.0);
+        }
+    }
+
+private:
+    struct Result
+    {
+        unsigned long long events = 0;
+        unsigned long long ns = 0;
+        unsigned long long allocations = 0;
+    };
+
+    Result results[(int)Stream::Count];
+};
+
+struct Tank
+{
+    float pos[3];
+    float heading;
+};
+
+static const double FRAME_TIME = 0.05; // Each player sends an update every frame
+static const float WORLD_HALF_SIZE = 400;
+static const float PI = 3.14159265f;
+
+int main(int argc, char* argv[])
+{
+    int playerCount = 100;
+    int mineCount = 1000;
+    int frames = 2000;
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-players") == 0 && i + 1 < argc)
+        {
+            playerCount = std::max(1, std::min(200, atoi(argv[++i])));
+        }
+        else if (strcmp(argv[i], "-mines") == 0 && i + 1 < argc)
+        {
+            mineCount = std::max(0, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc)
+        {
+            frames = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+        {
+            seed = (unsigned int)atoi(argv[++i]);
+        }
+        else if (const char* equals = strchr(argv[i], '='))
+        {
+            FakeServer::bzdb[std::string(argv[i], equals - argv[i])] = equals + 1;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-players N] [-mines N] [-frames N] [-seed N] [variable=value...]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> coordinate(-WORLD_HALF_SIZE, WORLD_HALF_SIZE);
+    std::uniform_real_distribution<float> angle(0, 2 * PI);
+    std::uniform_real_distribution<float> chance(0, 1);
+
+    // Keep the field at the requested size while players set mines off
+    FakeServer::bzdb["_mineMaxTotal"] = std::to_string(mineCount);
+
+    bz_Plugin* plugin = FakeServer::load();
+    Benchmark benchmark;
+
+    const bz_eTeamType teams[] = {eRogueTeam, eRedTeam, eGreenTeam, eBlueTeam, ePurpleTeam};
+    std::vector<Tank> tanks(playerCount);
+
+    for (int i = 0; i < playerCount; i++)
+    {
+        Tank &tank = tanks[i];
+        tank.pos[0] = coordinate(random);
+        tank.pos[1] = coordinate(random);
+        tank.pos[2] = 0;
+        tank.heading = angle(random);
+
+        FakeServer::join(i, teams[i % 5], "player" + std::to_string(i));
+        FakeServer::spawn(i, tank.pos);
+    }
+
+    // Lay a mine at a random spot as a random player, as if they had driven there
+    auto layMine = [&]() {
+        int playerID = (int)(random() % playerCount);
+        bz_BasePlayerRecord &record = FakeServer::players[playerID];
+        float pos[3] = {coordinate(random), coordinate(random), 0};
+
+        std::copy(pos, pos + 3, record.lastKnownState.pos);
+        record.currentFlag = "USeless (+US)";
+
+        benchmark.measure(Benchmark::Stream::MineCommand, 1, [&]() {
+            FakeServer::command(playerID, "mine");
+        });
+
+        std::copy(tanks[playerID].pos, tanks[playerID].pos + 3, record.lastKnownState.pos);
+    };
+
+    size_t minesLaid = 0;
+
+    for (; minesLaid < (size_t)mineCount; minesLaid++)
+    {
+        layMine();
+    }
+
+    std::vector<bz_PlayerUpdateEventData_V1> updates(playerCount);
+    float speed = (float)atof(FakeServer::bzdb["_tankSpeed"].c_str());
+    size_t shotsSeen = FakeServer::shots.size();
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        // Every player drives forward and sometimes turns, bouncing off the edges of the world
+        for (int i = 0; i < playerCount; i++)
+        {
+            Tank &tank = tanks[i];
+
+            if (chance(random) < 0.05f)
+            {
+                tank.heading = angle(random);
+            }
+
+            for (int axis = 0; axis < 2; axis++)
+            {
+                float step = speed * (float)FRAME_TIME * ((axis == 0) ? std::cos(tank.heading) : std::sin(tank.heading));
+                tank.pos[axis] += step;
+
+                if (std::fabs(tank.pos[axis]) > WORLD_HALF_SIZE)
+                {
+                    tank.pos[axis] -= 2 * step;
+                    tank.heading += PI / 2;
+                }
+            }
+
+            bz_PlayerUpdateEventData_V1 &update = updates[i];
+            update.playerID = i;
+            update.lastState = FakeServer::players[i].lastKnownState;
+            std::copy(tank.pos, tank.pos + 3, update.state.pos);
+            update.stateTime = FakeServer::currentTime;
+            FakeServer::players[i].lastKnownState = update.state;
+        }
+
+        benchmark.measure(Benchmark::Stream::Update, playerCount, [&]() {
+            for (bz_PlayerUpdateEventData_V1 &update : updates)
+            {
+                plugin->Event(&update);
+            }
+        });
+
+        FakeServer::currentTime += FRAME_TIME;
+
+        benchmark.measure(Benchmark::Stream::Tick, 1, [&]() {
+            FakeServer::tick();
+        });
+
+        // The closest player to each explosion dies from it and respawns somewhere else
+        for (; shotsSeen < FakeServer::shots.size(); shotsSeen++)
+        {
+            const FakeServer::Shot &shot = FakeServer::shots[shotsSeen];
+            int victimID = -1;
+            float closest = 0;
+
+            for (int i = 0; i < playerCount; i++)
+            {
+                float dx = tanks[i].pos[0] - shot.pos[0], dy = tanks[i].pos[1] - shot.pos[1];
+
+                if (FakeServer::players[i].spawned && (victimID < 0 || dx * dx + dy * dy < closest))
+                {
+                    victimID = i;
+                    closest = dx * dx + dy * dy;
+                }
+            }
+
+            if (victimID < 0)
+            {
+                continue;
+            }
+
+            benchmark.measure(Benchmark::Stream::Die, 1, [&]() {
+                FakeServer::die(victimID, BZ_SERVER, (int)shot.guid);
+            });
+
+            Tank &tank = tanks[victimID];
+            tank.pos[0] = coordinate(random);
+            tank.pos[1] = coordinate(random);
+
+            benchmark.measure(Benchmark::Stream::Spawn, 1, [&]() {
+                FakeServer::spawn(victimID, tank.pos);
+            });
+        }
+
+        // Replace the mines that were set off
+        for (; minesLaid - FakeServer::shots.size() < (size_t)mineCount; minesLaid++)
+        {
+            layMine();
+        }
+    }
+
+    printf("%d players, %d mines, %d frames, %zu explosions\n\n", playerCount, mineCount, frames, FakeServer::shots.size());
+    benchmark.print();
+
+    FakeServer::unload();
+
+    return 0;
+}
@@ -0,0 +1,218 @@
+/*
+    Copyright (C) 2013-2018 Vladimir "allejo" Jimenez
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the “Software”), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// Checks that the SSE2 and AVX2 proximity kernels find exactly the same mines, in the same order, as the scalar
+// kernel on randomized blocks of mines. The blocks mix every length up to a few vectors, so the scalar tail is covered,
+// with coordinates that sit exactly on or next to the query bounds, NaNs, infinities and negative zeros, and with
+// owners and teams that often match the query. A kernel the CPU doesn't support is skipped.
+//
+//   ./UselessMineKernelTest [-blocks N] [-seed N]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "../UselessMineKernels.h"
+
+// The number of extra hit slots checked after the hits a kernel reports, and the value they're filled with
+const unsigned int GUARD = 8;
+const unsigned int GUARD_VALUE = 0xDEADBEEF;
+
+class KernelTest
+{
+public:
+    KernelTest(unsigned int seed) :
+        random(seed)
+    {
+    }
+
+    // Fill a block with mines and pick a query that many of them are close to
+    void generate()
+    {
+        unsigned int count = random() % 70;
+
+        x.resize(count);
+        y.resize(count);
+        z.resize(count);
+        owner.resize(count);
+        team.resize(count);
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float center = uniform(-400, 400);
+            float size = uniform(0, 40);
+
+            query.min[axis] = center - size;
+            query.max[axis] = center + size;
+        }
+
+        query.playerID = (int)(random() % 8);
+        query.team = (int)(random() % 5);
+        query.anyTeam = (random() % 2) == 0;
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            x[i] = coordinate(0);
+            y[i] = coordinate(1);
+            z[i] = coordinate(2);
+            owner[i] = (int)(random() % 8);
+            team[i] = (int)(random() % 5);
+        }
+    }
+
+    // Run a kernel on the current block and compare it with the scalar kernel; returns false and describes the first
+    // difference if they disagree
+    bool compare(const char* name, ProximityKernel kernel)
+    {
+        unsigned int count = (unsigned int)x.size();
+
+        // Anything a kernel writes past the hits it reports is caught by the guard values
+        std::vector<unsigned int> expected(count + GUARD, GUARD_VALUE), actual(count + GUARD, GUARD_VALUE);
+
+        unsigned int expectedCount = findNearbyMinesScalar(x.data(), y.data(), z.data(), owner.data(), team.data(), count, query, expected.data());
+        unsigned int actualCount = kernel(x.data(), y.data(), z.data(), owner.data(), team.data(), count, query, actual.data());
+
+        if (actualCount != expectedCount)
+        {
+            printf("%s found %u of %u mines; the scalar kernel found %u\n", name, actualCount, count, expectedCount);
+            return false;
+        }
+
+        for (unsigned int i = 0; i < count + GUARD; i++)
+        {
+            if (actual[i] != expected[i])
+            {
+                printf("%s wrote %u at hit %u of a block of %u mines; the scalar kernel wrote %u\n", name, actual[i], i, count, expected[i]);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    float uniform(float low, float high)
+    {
+        return std::uniform_real_distribution<float>(low, high)(random);
+    }
+
+    // A coordinate that's usually near the query's bounds on the given axis, and sometimes exactly on them or not a
+    // number at all
+    float coordinate(int axis)
+    {
+        float low = query.min[axis], high = query.max[axis];
+
+        switch (random() % 12)
+        {
+            case 0:  return low;
+            case 1:  return high;
+            case 2:  return std::nextafter(low, -std::numeric_limits<float>::infinity());
+            case 3:  return std::nextafter(low, std::numeric_limits<float>::infinity());
+            case 4:  return std::nextafter(high, -std::numeric_limits<float>::infinity());
+            case 5:  return std::nextafter(high, std::numeric_limits<float>::infinity());
+            case 6:  return std::numeric_limits<float>::quiet_NaN();
+            case 7:  return (random() % 2) ? std::numeric_limits<float>::infinity() : -std::numeric_limits<float>::infinity();
+            case 8:  return (random() % 2) ? 0.0f : -0.0f;
+            default: return uniform(low - 20, high + 20);
+        }
+    }
+
+    std::mt19937 random;
+    std::vector<float> x, y, z;
+    std::vector<int> owner, team;
+    ProximityQuery query;
+};
+
+int main(int argc, char* argv[])
+{
+    int blocks = 200000;
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-blocks") == 0 && i + 1 < argc)
+        {
+            blocks = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+        {
+            seed = (unsigned int)atoi(argv[++i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-blocks N] [-seed N]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<std::pair<const char*, ProximityKernel>> kernels;
+
+#ifdef USELESSMINE_SSE2
+    kernels.push_back(std::make_pair("SSE2", findNearbyMinesSSE2));
+#endif
+
+#ifdef USELESSMINE_AVX2
+    if (__builtin_cpu_supports("avx2"))
+    {
+        kernels.push_back(std::make_pair("AVX2", findNearbyMinesAVX2));
+    }
+    else
+    {
+        printf("Skipping AVX2, which this CPU doesn't support\n");
+    }
+#endif
+
+    if (kernels.empty())
+    {
+        printf("No vectorized kernels were compiled in; only the scalar kernel is used\n");
+        return 0;
+    }
+
+    KernelTest test(seed);
+
+    for (int block = 0; block < blocks; block++)
+    {
+        test.generate();
+
+        for (auto &kernel : kernels)
+        {
+            if (!test.compare(kernel.first, kernel.second))
+            {
+                printf("FAILED on block %d with seed %u\n", block, seed);
+                return 1;
+            }
+        }
+    }
+
+    for (auto &kernel : kernels)
+    {
+        printf("%s matches the scalar kernel on %d blocks\n", kernel.first, blocks);
+    }
+
+    return 0;
+}
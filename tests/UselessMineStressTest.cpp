@@ -0,0 +1,862 @@
+/*
+    Copyright (C) 2013-2018 Vladimir "allejo" Jimenez
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the “Software”), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// Plays randomized matches against the plug-in and against a reference that checks every mine on the field for every
+// player update, the way the plug-in originally did, and stops at the first decision they disagree on. Matches are
+// open FFA, team FFA or rabbit chase, and have players joining, leaving and rejoining on other teams, becoming the
+// rabbit while alive, spawning on top of mines during their safety time, picking up, dropping and stealing Bomb
+// Defusal flags, and laying thousands of mines. Every explosion is compared: whether a
+// mine went off at all, which one, whether it was defused, and who the plug-in credits with the kill.
+//
+// With -curve, the plug-in and the reference are instead timed on the same stream of player updates over fields of more
+// and more mines, and the number of updates each handles per second is printed for each field size.
+//
+//   ./UselessMineStressTest [-seed N] [-runs N] [-steps N] [-players N] [-rebuild RADIUS] [variable=value...]
+//   ./UselessMineStressTest -curve [-seed N] [-players N] [-updates N] [variable=value...]
+//
+// Any variable=value argument sets a BZDB variable before the plug-in is loaded. With _mineWorkerThread=1, the match
+// waits for the background thread after every update that should set off a mine, so its decisions can be compared too.
+// -rebuild changes _shockOutRadius halfway through each match, which makes the plug-in rebuild its mine grid.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+
+#include "FakeServer.h"
+
+// How long to wait for the background thread to report a mine the reference set off before calling it a miss
+const double WORKER_TIMEOUT = 2;
+
+// Players are spread over a square this far from the center in every direction
+const float WORLD_HALF_SIZE = 400;
+
+// The original behaviour of the plug-in: every mine is checked, in the order they were laid, for every player update
+class ReferenceServer
+{
+public:
+    struct Mine
+    {
+        int owner;
+        float pos[3];
+        bz_eTeamType team;
+        double expiresAt;
+    };
+
+    struct Player
+    {
+        bz_eTeamType team;
+        bool spawned;
+        bool defusal;
+        double spawnTime;
+        bool hasCheckedPos;
+        float checkedPos[3];
+        double checkedTime;
+    };
+
+    // A mine set off by a player update
+    struct Explosion
+    {
+        bool defusal;
+        int triggeredBy;
+        int mineOwner;
+        float pos[3];
+        bz_eTeamType team;
+    };
+
+    // Read the settings the plug-in uses from BZDB
+    void configure()
+    {
+        shockRange = atof(FakeServer::bzdb["_shockOutRadius"].c_str()) * 0.75;
+        maxTankSpeed = atof(FakeServer::bzdb["_tankSpeed"].c_str()) * std::max(1.0, atof(FakeServer::bzdb["_velocityAd"].c_str()));
+        safetyTime = atoi(FakeServer::bzdb["_mineSafetyTime"].c_str());
+        lifetime = atoi(FakeServer::bzdb["_mineLifetime"].c_str());
+        maxPerPlayer = atoi(FakeServer::bzdb["_mineMaxPerPlayer"].c_str());
+        maxTotal = atoi(FakeServer::bzdb["_mineMaxTotal"].c_str());
+        anyTeam = (FakeServer::gameType == eOpenFFAGame);
+    }
+
+    void reset()
+    {
+        mines.clear();
+        players.clear();
+    }
+
+    void join(int playerID, bz_eTeamType team)
+    {
+        Player &player = players[playerID];
+        player = Player();
+        player.team = team;
+        player.spawnTime = -1;
+    }
+
+    void part(int playerID)
+    {
+        players.erase(playerID);
+        mines.erase(std::remove_if(mines.begin(), mines.end(), [playerID](const Mine &mine) { return mine.owner == playerID; }), mines.end());
+    }
+
+    void spawn(int playerID, double now)
+    {
+        Player &player = players[playerID];
+        player.spawned = true;
+        player.defusal = false;
+        player.spawnTime = now;
+        player.hasCheckedPos = false;
+    }
+
+    void die(int playerID)
+    {
+        players[playerID].spawned = false;
+        players[playerID].defusal = false;
+    }
+
+    void setDefusal(int playerID, bool defusal)
+    {
+        players[playerID].defusal = defusal;
+    }
+
+    void newRabbit(int playerID)
+    {
+        for (auto &player : players)
+        {
+            if (player.second.team == eRabbitTeam)
+            {
+                player.second.team = eHunterTeam;
+            }
+        }
+
+        players[playerID].team = eRabbitTeam;
+    }
+
+    void placeMine(int playerID, const float pos[3], double now)
+    {
+        if (maxPerPlayer > 0)
+        {
+            while (std::count_if(mines.begin(), mines.end(), [playerID](const Mine &mine) { return mine.owner == playerID; }) >= maxPerPlayer)
+            {
+                mines.erase(std::find_if(mines.begin(), mines.end(), [playerID](const Mine &mine) { return mine.owner == playerID; }));
+            }
+        }
+
+        while (maxTotal > 0 && (int)mines.size() >= maxTotal)
+        {
+            mines.erase(mines.begin());
+        }
+
+        Mine mine;
+        mine.owner = playerID;
+        std::copy(pos, pos + 3, mine.pos);
+        mine.team = players[playerID].team;
+        mine.expiresAt = (lifetime > 0) ? now + lifetime : 0;
+        mines.push_back(mine);
+    }
+
+    // The plug-in's timers have a resolution of a quarter second, so a mine is removed on the first tick once the time
+    // has reached its expiry time rounded up to a quarter second
+    void removeExpiredMines(double now)
+    {
+        mines.erase(std::remove_if(mines.begin(), mines.end(), [now](const Mine &mine) {
+            return mine.expiresAt > 0 && std::ceil(mine.expiresAt * 4) <= std::floor(now * 4);
+        }), mines.end());
+    }
+
+    // Check a player update against every mine; returns true and describes the explosion if a mine went off
+    bool move(int playerID, const float pos[3], double now, Explosion &explosion)
+    {
+        Player &player = players[playerID];
+
+        if (player.hasCheckedPos)
+        {
+            double dx = pos[0] - player.checkedPos[0], dy = pos[1] - player.checkedPos[1], dz = pos[2] - player.checkedPos[2];
+
+            // A player moving faster than a tank can drive went through a teleporter
+            if (std::sqrt(dx * dx + dy * dy + dz * dz) > maxTankSpeed * 2 * (now - player.checkedTime) + shockRange)
+            {
+                player.hasCheckedPos = false;
+            }
+        }
+
+        float from[3];
+        std::copy(player.hasCheckedPos ? player.checkedPos : pos, (player.hasCheckedPos ? player.checkedPos : pos) + 3, from);
+
+        player.hasCheckedPos = true;
+        std::copy(pos, pos + 3, player.checkedPos);
+        player.checkedTime = now;
+
+        if (!player.spawned || player.spawnTime + safetyTime > now)
+        {
+            return false;
+        }
+
+        for (size_t i = 0; i < mines.size(); i++)
+        {
+            const Mine &mine = mines[i];
+
+            if (mine.owner == playerID || (!anyTeam && player.team != eRogueTeam && mine.team == player.team))
+            {
+                continue;
+            }
+
+            if (!isInTriggerBox(mine, pos) && !isPathInTriggerBox(mine, from, pos))
+            {
+                continue;
+            }
+
+            // Mines of observers neither go off nor can be defused
+            const Player &owner = players[mine.owner];
+
+            if (owner.team == eObservers)
+            {
+                continue;
+            }
+
+            explosion.defusal = player.defusal;
+            explosion.triggeredBy = playerID;
+            explosion.mineOwner = mine.owner;
+
+            if (player.defusal)
+            {
+                // A defused mine goes off where its owner is, in the defuser's team color
+                std::copy(FakeServer::players[mine.owner].lastKnownState.pos, FakeServer::players[mine.owner].lastKnownState.pos + 3, explosion.pos);
+                explosion.team = player.team;
+            }
+            else
+            {
+                std::copy(mine.pos, mine.pos + 3, explosion.pos);
+                explosion.team = mine.team;
+            }
+
+            mines.erase(mines.begin() + i);
+
+            return true;
+        }
+
+        return false;
+    }
+
+    const Player* getPlayer(int playerID) const
+    {
+        auto it = players.find(playerID);
+
+        return (it == players.end()) ? nullptr : &it->second;
+    }
+
+    const std::vector<Mine>& getMines() const
+    {
+        return mines;
+    }
+
+private:
+    bool isInTriggerBox(const Mine &mine, const float pos[3]) const
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (!(pos[axis] > mine.pos[axis] - shockRange && pos[axis] < mine.pos[axis] + shockRange))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool isPathInTriggerBox(const Mine &mine, const float from[3], const float to[3]) const
+    {
+        double enter = 0, exit = 1;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            double low = mine.pos[axis] - shockRange, high = mine.pos[axis] + shockRange;
+            double delta = (double)to[axis] - from[axis];
+
+            if (delta == 0)
+            {
+                if (!(from[axis] > low && from[axis] < high))
+                {
+                    return false;
+                }
+
+                continue;
+            }
+
+            double t0 = (low - from[axis]) / delta, t1 = (high - from[axis]) / delta;
+
+            if (t0 > t1)
+            {
+                std::swap(t0, t1);
+            }
+
+            enter = std::max(enter, t0);
+            exit = std::min(exit, t1);
+
+            if (enter >= exit)
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::vector<Mine> mines; // In the order they were laid
+    std::map<int, Player> players;
+
+    double shockRange = 0;
+    double maxTankSpeed = 0;
+    int safetyTime = 0;
+    int lifetime = 0;
+    int maxPerPlayer = 0;
+    int maxTotal = 0;
+    bool anyTeam = false;
+};
+
+class StressTest
+{
+public:
+    StressTest(unsigned int _seed, int _playerCount) :
+        seed(_seed),
+        playerCount(_playerCount),
+        random(_seed)
+    {
+        workerThread = atoi(FakeServer::bzdb["_mineWorkerThread"].c_str()) != 0;
+    }
+
+    // Play a randomized match, returning false at the first decision the plug-in and the reference disagree on
+    bool playMatch(int steps, const char* rebuildRadius)
+    {
+        const bz_eGameType gameTypes[] = {eOpenFFAGame, eTeamFFAGame, eRabbitGame};
+        FakeServer::gameType = gameTypes[seed % 3];
+        start();
+
+        for (int i = 0; i < playerCount; i++)
+        {
+            join(i);
+            spawn(i);
+        }
+
+        unsigned long long updates = 0;
+        size_t mostMines = 0;
+
+        for (step = 0; step < steps; step++)
+        {
+            if (rebuildRadius && step == steps / 2)
+            {
+                FakeServer::set("_shockOutRadius", rebuildRadius);
+                reference.configure();
+            }
+
+            int playerID = (int)(random() % playerCount);
+            const ReferenceServer::Player &player = *reference.getPlayer(playerID);
+            int action = (int)(random() % 1000);
+
+            if (action < 60)
+            {
+                if (player.spawned)
+                {
+                    layMine(playerID);
+                    mostMines = std::max(mostMines, reference.getMines().size());
+                }
+            }
+            else if (action < 65)
+            {
+                if (player.spawned)
+                {
+                    FakeServer::grabFlag(playerID, "BD");
+                    reference.setDefusal(playerID, true);
+                }
+            }
+            else if (action < 69)
+            {
+                if (player.spawned)
+                {
+                    FakeServer::dropFlag(playerID);
+                    reference.setDefusal(playerID, false);
+                }
+            }
+            else if (action < 71)
+            {
+                // Steal another player's flag with Thief
+                int victimID = (int)(random() % playerCount);
+
+                if (player.spawned && victimID != playerID && reference.getPlayer(victimID)->spawned)
+                {
+                    bool defusal = reference.getPlayer(victimID)->defusal;
+
+                    FakeServer::transferFlag(victimID, playerID);
+                    reference.setDefusal(victimID, false);
+                    reference.setDefusal(playerID, defusal);
+                }
+            }
+            else if (action < 75)
+            {
+                if (player.spawned)
+                {
+                    FakeServer::die(playerID);
+                    reference.die(playerID);
+                }
+            }
+            else if (action < 76)
+            {
+                // Leave and come back, usually on another team
+                FakeServer::part(playerID);
+                reference.part(playerID);
+                join(playerID);
+
+                if (random() % 2)
+                {
+                    spawn(playerID);
+                }
+            }
+            else if (action < 77 && FakeServer::gameType == eRabbitGame)
+            {
+                // Anoint a new rabbit while they're alive, as happens when they kill the old one
+                if (player.spawned)
+                {
+                    FakeServer::newRabbit(playerID);
+                    reference.newRabbit(playerID);
+                }
+            }
+            else if (action < 79)
+            {
+                FakeServer::currentTime += uniform(0, 0.5);
+                tick();
+            }
+            else
+            {
+                // Players who are dead respawn the next time they'd have moved
+                if (!player.spawned)
+                {
+                    spawn(playerID);
+                    continue;
+                }
+
+                update(playerID);
+                updates++;
+            }
+
+            if (!checkExplosions())
+            {
+                return false;
+            }
+        }
+
+        // Give the background thread a chance to report anything the reference didn't expect
+        if (workerThread)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            tick();
+
+            if (!checkExplosions())
+            {
+                return false;
+            }
+        }
+
+        printf("seed %u: %s, %d players, %llu updates, %zu explosions (%llu defused), up to %zu mines on the field\n",
+               seed, gameTypeName(FakeServer::gameType), playerCount, updates, explosions.size(),
+               (unsigned long long)std::count_if(explosions.begin(), explosions.end(), [](const ReferenceServer::Explosion &explosion) { return explosion.defusal; }),
+               mostMines);
+
+        stop();
+
+        return true;
+    }
+
+    // Time the plug-in and the reference on the same player updates over a field of `mineCount` mines
+    void measure(int mineCount, int updateCount)
+    {
+        FakeServer::gameType = eTeamFFAGame;
+        start();
+
+        std::vector<float> headings(playerCount);
+
+        for (int i = 0; i < playerCount; i++)
+        {
+            join(i, false);
+            spawn(i);
+            headings[i] = uniform(0, 6.2831853f);
+        }
+
+        for (int i = 0; i < mineCount; i++)
+        {
+            layMine((int)(random() % playerCount));
+        }
+
+        // Measure once everyone's safety time is over
+        FakeServer::currentTime += atoi(FakeServer::bzdb["_mineSafetyTime"].c_str()) + 1;
+
+        // Every player drives forward, sometimes turning, and sends an update every frame
+        struct Update
+        {
+            int playerID;
+            float pos[3];
+            double time;
+        };
+
+        const double frameTime = 0.05;
+        float speed = (float)atof(FakeServer::bzdb["_tankSpeed"].c_str());
+        std::vector<Update> updates(updateCount);
+        std::vector<std::vector<float>> positions(playerCount);
+
+        for (int i = 0; i < playerCount; i++)
+        {
+            const float* pos = FakeServer::players[i].lastKnownState.pos;
+            positions[i].assign(pos, pos + 3);
+        }
+
+        for (int n = 0; n < updateCount; n++)
+        {
+            int playerID = n % playerCount;
+            double time = FakeServer::currentTime + (n / playerCount) * frameTime;
+
+            if (uniform(0, 1) < 0.05f)
+            {
+                headings[playerID] = uniform(0, 6.2831853f);
+            }
+
+            std::vector<float> &pos = positions[playerID];
+            pos[0] = std::max(-WORLD_HALF_SIZE, std::min(WORLD_HALF_SIZE, pos[0] + speed * (float)frameTime * std::cos(headings[playerID])));
+            pos[1] = std::max(-WORLD_HALF_SIZE, std::min(WORLD_HALF_SIZE, pos[1] + speed * (float)frameTime * std::sin(headings[playerID])));
+
+            updates[n].playerID = playerID;
+            std::copy(pos.begin(), pos.end(), updates[n].pos);
+            updates[n].time = time;
+        }
+
+        auto pluginStart = std::chrono::steady_clock::now();
+
+        for (int n = 0; n < updateCount; n++)
+        {
+            FakeServer::currentTime = updates[n].time;
+            FakeServer::move(updates[n].playerID, updates[n].pos);
+
+            if ((n + 1) % playerCount == 0)
+            {
+                FakeServer::tick();
+            }
+        }
+
+        auto pluginEnd = std::chrono::steady_clock::now();
+
+        std::vector<ReferenceServer::Explosion> referenceExplosions;
+        ReferenceServer::Explosion explosion;
+
+        for (int n = 0; n < updateCount; n++)
+        {
+            if (reference.move(updates[n].playerID, updates[n].pos, updates[n].time, explosion))
+            {
+                referenceExplosions.push_back(explosion);
+            }
+        }
+
+        auto referenceEnd = std::chrono::steady_clock::now();
+
+        double pluginNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(pluginEnd - pluginStart).count() / updateCount;
+        double referenceNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(referenceEnd - pluginEnd).count() / updateCount;
+
+        // With the background thread, mines go off on a later tick, so only the time spent on the main thread is comparable
+        const char* result = "-";
+
+        if (!workerThread)
+        {
+            bool same = (referenceExplosions.size() == FakeServer::shots.size());
+
+            for (size_t i = 0; same && i < referenceExplosions.size(); i++)
+            {
+                same = std::equal(referenceExplosions[i].pos, referenceExplosions[i].pos + 3, FakeServer::shots[i].pos);
+            }
+
+            result = same ? "same" : "DIFFERENT";
+        }
+
+        printf("%8d %10d %12.1f %12.1f %14.0f %14.0f %8.1fx %11zu %10s\n", mineCount, updateCount, referenceNs, pluginNs,
+               1e9 / referenceNs, 1e9 / pluginNs, referenceNs / pluginNs, FakeServer::shots.size(), result);
+
+        stop();
+    }
+
+private:
+    void start()
+    {
+        FakeServer::players.clear();
+        FakeServer::load();
+
+        reference.reset();
+        reference.configure();
+
+        explosions.clear();
+        explosionsChecked = 0;
+    }
+
+    void stop()
+    {
+        FakeServer::unload();
+    }
+
+    float uniform(float low, float high)
+    {
+        return std::uniform_real_distribution<float>(low, high)(random);
+    }
+
+    void tick()
+    {
+        FakeServer::tick();
+        reference.removeExpiredMines(FakeServer::currentTime);
+    }
+
+    static const char* gameTypeName(bz_eGameType gameType)
+    {
+        switch (gameType)
+        {
+            case eOpenFFAGame: return "open FFA";
+            case eRabbitGame:  return "rabbit chase";
+            default:           return "team FFA";
+        }
+    }
+
+    // Join a random team, or the hunters in rabbit chase
+    void join(int playerID, bool canObserve = true)
+    {
+        const bz_eTeamType teams[] = {eRogueTeam, eRedTeam, eGreenTeam, eBlueTeam, ePurpleTeam};
+        bz_eTeamType team = (FakeServer::gameType == eRabbitGame) ? eHunterTeam : teams[random() % 5];
+
+        if (canObserve && random() % 30 == 0)
+        {
+            team = eObservers;
+        }
+
+        FakeServer::join(playerID, team, "player" + std::to_string(playerID));
+        reference.join(playerID, team);
+    }
+
+    // Spawn somewhere random, or often right on top of a mine so the safety time matters
+    void spawn(int playerID)
+    {
+        if (FakeServer::players[playerID].team == eObservers)
+        {
+            return;
+        }
+
+        const std::vector<ReferenceServer::Mine> &mines = reference.getMines();
+        float pos[3] = {uniform(-WORLD_HALF_SIZE, WORLD_HALF_SIZE), uniform(-WORLD_HALF_SIZE, WORLD_HALF_SIZE), 0};
+
+        if (!mines.empty() && random() % 3 == 0)
+        {
+            const ReferenceServer::Mine &mine = mines[random() % mines.size()];
+            std::copy(mine.pos, mine.pos + 3, pos);
+        }
+
+        FakeServer::spawn(playerID, pos);
+        reference.spawn(playerID, FakeServer::currentTime);
+    }
+
+    void layMine(int playerID)
+    {
+        FakeServer::grabFlag(playerID, "US");
+        reference.setDefusal(playerID, false);
+
+        FakeServer::command(playerID, "mine");
+        reference.placeMine(playerID, FakeServer::players[playerID].lastKnownState.pos, FakeServer::currentTime);
+    }
+
+    // Move a player a little, or sometimes right next to a mine, and check that the same mine goes off, if any
+    void update(int playerID)
+    {
+        const float* current = FakeServer::players[playerID].lastKnownState.pos;
+        float pos[3] = {current[0] + uniform(-1.5, 1.5), current[1] + uniform(-1.5, 1.5), std::max(0.0f, current[2] + uniform(-1, 1))};
+        const std::vector<ReferenceServer::Mine> &mines = reference.getMines();
+
+        if (!mines.empty() && random() % 100 == 0)
+        {
+            const ReferenceServer::Mine &mine = mines[random() % mines.size()];
+            pos[0] = mine.pos[0] + uniform(-10, 10);
+            pos[1] = mine.pos[1] + uniform(-10, 10);
+            pos[2] = std::max(0.0f, mine.pos[2] + uniform(-5, 5));
+        }
+
+        FakeServer::currentTime += 0.001;
+        FakeServer::move(playerID, pos);
+
+        ReferenceServer::Explosion explosion;
+        bool exploded = reference.move(playerID, pos, FakeServer::currentTime, explosion);
+
+        if (exploded)
+        {
+            explosions.push_back(explosion);
+        }
+
+        tick();
+
+        // The background thread's hits are acted on during a tick, so keep ticking until the expected one shows up
+        if (workerThread && exploded)
+        {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(WORKER_TIMEOUT);
+
+            while (FakeServer::shots.size() < explosions.size() && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::yield();
+                tick();
+            }
+        }
+    }
+
+    // Compare the explosions since the last call, then kill the player each one was meant for and make sure the
+    // plug-in credits the right player
+    bool checkExplosions()
+    {
+        if (FakeServer::shots.size() != explosions.size())
+        {
+            printf("FAILED at step %d with seed %u: the plug-in set off %zu mines, the reference %zu\n", step, seed, FakeServer::shots.size(), explosions.size());
+            return false;
+        }
+
+        for (; explosionsChecked < explosions.size(); explosionsChecked++)
+        {
+            const ReferenceServer::Explosion &expected = explosions[explosionsChecked];
+            const FakeServer::Shot &shot = FakeServer::shots[explosionsChecked];
+
+            if (!std::equal(expected.pos, expected.pos + 3, shot.pos) || expected.team != shot.team)
+            {
+                printf("FAILED at step %d with seed %u: explosion %zu was at (%.2f, %.2f, %.2f) for team %d, expected %s at (%.2f, %.2f, %.2f) for team %d\n",
+                       step, seed, explosionsChecked, shot.pos[0], shot.pos[1], shot.pos[2], shot.team, expected.defusal ? "a defusal" : "a detonation",
+                       expected.pos[0], expected.pos[1], expected.pos[2], expected.team);
+                return false;
+            }
+
+            // A detonation kills the player who set it off, and a defusal kills the mine's owner
+            int victimID = expected.defusal ? expected.mineOwner : expected.triggeredBy;
+            int killerID = expected.defusal ? expected.triggeredBy : expected.mineOwner;
+            const ReferenceServer::Player* victim = reference.getPlayer(victimID);
+
+            if (!victim || !victim->spawned)
+            {
+                continue;
+            }
+
+            int creditedID = FakeServer::die(victimID, BZ_SERVER, (int)shot.guid);
+            reference.die(victimID);
+
+            if (creditedID != killerID)
+            {
+                printf("FAILED at step %d with seed %u: player %d's death was credited to %d, expected %d\n", step, seed, victimID, creditedID, killerID);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    unsigned int seed;
+    int playerCount;
+    bool workerThread;
+    std::mt19937 random;
+    ReferenceServer reference;
+    std::vector<ReferenceServer::Explosion> explosions;
+    size_t explosionsChecked = 0;
+    int step = 0;
+};
+
+int main(int argc, char* argv[])
+{
+    unsigned int seed = 1;
+    int runs = 1;
+    int steps = 300000;
+    int playerCount = 200;
+    int updateCount = 20000;
+    const char* rebuildRadius = nullptr;
+    bool curve = false;
+
+    // Mines are only a few units across so thousands of them fit on the field
+    FakeServer::bzdb["_shockOutRadius"] = "12";
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-seed") == 0 && i + 1 < argc)
+        {
+            seed = (unsigned int)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-runs") == 0 && i + 1 < argc)
+        {
+            runs = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-steps") == 0 && i + 1 < argc)
+        {
+            steps = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-players") == 0 && i + 1 < argc)
+        {
+            playerCount = std::max(2, std::min(200, atoi(argv[++i])));
+        }
+        else if (strcmp(argv[i], "-updates") == 0 && i + 1 < argc)
+        {
+            updateCount = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-rebuild") == 0 && i + 1 < argc)
+        {
+            rebuildRadius = argv[++i];
+        }
+        else if (strcmp(argv[i], "-curve") == 0)
+        {
+            curve = true;
+        }
+        else if (const char* equals = strchr(argv[i], '='))
+        {
+            FakeServer::bzdb[std::string(argv[i], equals - argv[i])] = equals + 1;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-seed N] [-runs N] [-steps N] [-players N] [-rebuild RADIUS] [variable=value...]\n"
+                            "       %s -curve [-seed N] [-players N] [-updates N] [variable=value...]\n", argv[0], argv[0]);
+            return 1;
+        }
+    }
+
+    if (curve)
+    {
+        const int mineCounts[] = {0, 250, 500, 1000, 2000, 4000, 8000, 16000};
+
+        printf("%8s %10s %12s %12s %14s %14s %9s %11s %10s\n", "Mines", "Updates", "Linear ns", "Plug-in ns",
+               "Linear upd/s", "Plug-in upd/s", "Speedup", "Explosions", "Decisions");
+
+        for (int mineCount : mineCounts)
+        {
+            StressTest(seed, playerCount).measure(mineCount, updateCount);
+        }
+
+        return 0;
+    }
+
+    for (int run = 0; run < runs; run++)
+    {
+        if (!StressTest(seed + run, playerCount).playMatch(steps, rebuildRadius))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
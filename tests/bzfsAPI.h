@@ -0,0 +1,365 @@
+/*
+    Copyright (C) 2013-2018 Vladimir "allejo" Jimenez
+
+    Permission is hereby granted, free of charge, to any person obtaining a copy
+    of this software and associated documentation files (the “Software”), to deal
+    in the Software without restriction, including without limitation the rights
+    to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+    copies of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be included in
+    all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+    AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+    LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+    THE SOFTWARE.
+*/
+
+// A stand-in for the parts of BZFlag's bzfsAPI.h that UselessMine.cpp uses, so the plug-in can be built and measured
+// without a BZFlag source tree. The declarations follow the real API; anything the plug-in doesn't touch is left out.
+// The functions are implemented by FakeServer.cpp.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#define BZF_API
+
+#define BZ_SERVER   -2
+#define BZ_ALLUSERS -1
+
+class bz_Plugin;
+
+#define BZ_PLUGIN(n) \
+    extern "C" bz_Plugin* bz_GetPlugin(void) { return new n; } \
+    extern "C" void bz_FreePlugin(bz_Plugin* plugin) { delete plugin; } \
+    extern "C" int bz_GetMinVersion(void) { return 0; }
+
+typedef enum
+{
+    eNoTeam = -1,
+    eRogueTeam = 0,
+    eRedTeam,
+    eGreenTeam,
+    eBlueTeam,
+    ePurpleTeam,
+    eRabbitTeam,
+    eHunterTeam,
+    eObservers,
+    eAdministrators
+} bz_eTeamType;
+
+typedef enum
+{
+    eTeamFFAGame = 0,
+    eClassicCTFGame,
+    eRabbitGame,
+    eOpenFFAGame
+} bz_eGameType;
+
+typedef enum
+{
+    eGoodFlag = 0,
+    eBadFlag
+} bz_eFlagQuality;
+
+typedef enum
+{
+    bz_eNullEvent = 0,
+    bz_ePlayerDieEvent,
+    bz_ePlayerSpawnEvent,
+    bz_eTickEvent,
+    bz_ePlayerJoinEvent,
+    bz_ePlayerPartEvent,
+    bz_eFlagGrabbedEvent,
+    bz_eFlagDroppedEvent,
+    bz_eFlagTransferredEvent,
+    bz_ePlayerUpdateEvent,
+    bz_eBZDBChange,
+    bz_eWorldFinalized,
+    bz_eShotEndedEvent,
+    bz_eNewRabbitEvent
+} bz_eEventType;
+
+class bz_ApiString
+{
+public:
+    bz_ApiString() {}
+    bz_ApiString(const char* text) : data(text ? text : "") {}
+    bz_ApiString(const std::string &text) : data(text) {}
+
+    const char* c_str() const { return data.c_str(); }
+    int size() const { return (int)data.size(); }
+
+    bool operator==(const char* text) const { return data == text; }
+    bool operator!=(const char* text) const { return data != text; }
+    bool operator==(const bz_ApiString &other) const { return data == other.data; }
+
+    operator std::string() const { return data; }
+
+private:
+    std::string data;
+};
+
+class bz_APIStringList
+{
+public:
+    void push_back(const std::string &value) { items.push_back(value); }
+    bz_ApiString get(unsigned int i) const { return bz_ApiString(items[i]); }
+    bz_ApiString operator[](unsigned int i) const { return get(i); }
+    unsigned int size() const { return (unsigned int)items.size(); }
+
+    void tokenize(const char* in, const char* delimiters, int maxTokens = 0, bool useQuotes = false);
+
+private:
+    std::vector<std::string> items;
+};
+
+class bz_APIIntList
+{
+public:
+    void push_back(int value) { items.push_back(value); }
+    void clear() { items.clear(); }
+    int get(unsigned int i) const { return items[i]; }
+    int operator[](unsigned int i) const { return items[i]; }
+    unsigned int size() const { return (unsigned int)items.size(); }
+
+private:
+    std::vector<int> items;
+};
+
+typedef struct
+{
+    int status;
+    bool falling;
+    bool crossingWall;
+    bool inPhantomZone;
+    float pos[3];
+    float velocity[3];
+    float rotation;
+    float angVel;
+    int phydrv;
+} bz_PlayerUpdateState;
+
+class bz_BasePlayerRecord
+{
+public:
+    int version;
+    int playerID;
+    bz_ApiString callsign;
+    bz_eTeamType team;
+    float lastUpdateTime;
+    bz_PlayerUpdateState lastKnownState;
+    bz_ApiString currentFlag;
+    int currentFlagID;
+    bool spawned;
+    bz_ApiString bzID;
+};
+
+class bz_EventData
+{
+public:
+    bz_EventData(bz_eEventType type = bz_eNullEvent) : eventType(type), eventTime(0) {}
+    virtual ~bz_EventData() {}
+
+    bz_eEventType eventType;
+    double eventTime;
+};
+
+class bz_BZDBChangeData_V1 : public bz_EventData
+{
+public:
+    bz_BZDBChangeData_V1() : bz_EventData(bz_eBZDBChange) {}
+
+    bz_ApiString key;
+    bz_ApiString value;
+};
+
+class bz_FlagGrabbedEventData_V1 : public bz_EventData
+{
+public:
+    bz_FlagGrabbedEventData_V1() : bz_EventData(bz_eFlagGrabbedEvent), playerID(-1), flagID(-1), flagType(nullptr) {}
+
+    int playerID;
+    int flagID;
+    const char* flagType;
+    float pos[3];
+};
+
+class bz_FlagDroppedEventData_V1 : public bz_EventData
+{
+public:
+    bz_FlagDroppedEventData_V1() : bz_EventData(bz_eFlagDroppedEvent), playerID(-1), flagID(-1), flagType(nullptr) {}
+
+    int playerID;
+    int flagID;
+    const char* flagType;
+    float pos[3];
+};
+
+class bz_FlagTransferredEventData_V1 : public bz_EventData
+{
+public:
+    bz_FlagTransferredEventData_V1() : bz_EventData(bz_eFlagTransferredEvent), fromPlayerID(-1), toPlayerID(-1), flagType(nullptr), action(0) {}
+
+    int fromPlayerID;
+    int toPlayerID;
+    const char* flagType;
+    int action;
+};
+
+class bz_NewRabbitEventData_V1 : public bz_EventData
+{
+public:
+    bz_NewRabbitEventData_V1() : bz_EventData(bz_eNewRabbitEvent), newRabbit(-1), swap(true) {}
+
+    int newRabbit;
+    bool swap;
+};
+
+class bz_PlayerDieEventData_V1 : public bz_EventData
+{
+public:
+    bz_PlayerDieEventData_V1() : bz_EventData(bz_ePlayerDieEvent), playerID(-1), team(eNoTeam), killerID(-1), killerTeam(eNoTeam), shotID(-1), state() {}
+
+    int playerID;
+    bz_eTeamType team;
+    int killerID;
+    bz_eTeamType killerTeam;
+    bz_ApiString flagKilledWith;
+    int shotID;
+    bz_PlayerUpdateState state;
+};
+
+class bz_PlayerJoinPartEventData_V1 : public bz_EventData
+{
+public:
+    bz_PlayerJoinPartEventData_V1(bz_eEventType type) : bz_EventData(type), playerID(-1), record(nullptr) {}
+
+    int playerID;
+    bz_BasePlayerRecord* record;
+    bz_ApiString reason;
+};
+
+class bz_PlayerSpawnEventData_V1 : public bz_EventData
+{
+public:
+    bz_PlayerSpawnEventData_V1() : bz_EventData(bz_ePlayerSpawnEvent), playerID(-1), team(eNoTeam), state() {}
+
+    int playerID;
+    bz_eTeamType team;
+    bz_PlayerUpdateState state;
+};
+
+class bz_PlayerUpdateEventData_V1 : public bz_EventData
+{
+public:
+    bz_PlayerUpdateEventData_V1() : bz_EventData(bz_ePlayerUpdateEvent), playerID(-1), state(), lastState(), stateTime(0) {}
+
+    int playerID;
+    bz_PlayerUpdateState state;
+    bz_PlayerUpdateState lastState;
+    double stateTime;
+};
+
+class bz_TickEventData_V1 : public bz_EventData
+{
+public:
+    bz_TickEventData_V1() : bz_EventData(bz_eTickEvent) {}
+};
+
+class bz_WorldFinalizedEventData_V1 : public bz_EventData
+{
+public:
+    bz_WorldFinalizedEventData_V1() : bz_EventData(bz_eWorldFinalized) {}
+};
+
+class bz_ShotEndedEventData_V1 : public bz_EventData
+{
+public:
+    bz_ShotEndedEventData_V1() : bz_EventData(bz_eShotEndedEvent), playerID(-1), shotID(-1), explode(false) {}
+
+    int playerID;
+    int shotID;
+    bool explode;
+};
+
+class bz_Plugin
+{
+public:
+    bz_Plugin() : MaxWaitTime(-1) {}
+    virtual ~bz_Plugin() {}
+
+    virtual const char* Name() = 0;
+    virtual void Init(const char* config) = 0;
+    virtual void Event(bz_EventData* eventData) = 0;
+    virtual void Cleanup() { Flush(); }
+
+    float MaxWaitTime;
+
+protected:
+    bool Register(bz_eEventType event);
+    void Flush();
+};
+
+class bz_CustomSlashCommandHandler
+{
+public:
+    virtual ~bz_CustomSlashCommandHandler() {}
+    virtual bool SlashCommand(int playerID, bz_ApiString command, bz_ApiString message, bz_APIStringList* params) = 0;
+};
+
+// BZDB
+BZF_API bool bz_registerCustomBZDBInt(const char* variable, int defaultValue, int perms = 0, bool persistent = false);
+BZF_API bool bz_registerCustomBZDBDouble(const char* variable, double defaultValue, int perms = 0, bool persistent = false);
+BZF_API bool bz_registerCustomBZDBBool(const char* variable, bool defaultValue, int perms = 0, bool persistent = false);
+BZF_API bool bz_registerCustomBZDBString(const char* variable, const char* defaultValue, int perms = 0, bool persistent = false);
+BZF_API bool bz_removeCustomBZDBVariable(const char* variable);
+BZF_API int bz_getBZDBInt(const char* variable);
+BZF_API double bz_getBZDBDouble(const char* variable);
+BZF_API bool bz_getBZDBBool(const char* variable);
+BZF_API bz_ApiString bz_getBZDBString(const char* variable);
+
+// Players
+BZF_API bz_APIIntList* bz_newIntList();
+BZF_API void bz_deleteIntList(bz_APIIntList* list);
+BZF_API bool bz_getPlayerIndexList(bz_APIIntList* playerList);
+BZF_API bz_BasePlayerRecord* bz_getPlayerByIndex(int index);
+BZF_API bool bz_freePlayerRecord(bz_BasePlayerRecord* playerRecord);
+BZF_API bz_eTeamType bz_getPlayerTeam(int playerID);
+BZF_API const char* bz_getPlayerCallsign(int playerID);
+BZF_API bool bz_hasPerm(int playerID, const char* perm);
+BZF_API bool bz_removePlayerFlag(int playerID);
+
+// Flags and shots
+BZF_API bool bz_RegisterCustomFlag(const char* abbr, const char* name, const char* helpString, int shotType, bz_eFlagQuality quality);
+BZF_API uint32_t bz_fireServerShot(const char* shotType, float origin[3], float vector[3], bz_eTeamType color = eRogueTeam, int targetPlayerId = -1);
+BZF_API uint32_t bz_getShotGUID(int fromPlayer, int shotID);
+BZF_API bool bz_shotHasMetaData(uint32_t shotGUID, const char* name);
+BZF_API uint32_t bz_getShotMetaDataI(uint32_t shotGUID, const char* name);
+BZF_API bool bz_setShotMetaData(uint32_t shotGUID, const char* name, uint32_t value);
+
+// Slash commands
+BZF_API bool bz_registerCustomSlashCommand(const char* command, bz_CustomSlashCommandHandler* handler);
+BZF_API bool bz_removeCustomSlashCommand(const char* command);
+
+// Messages and logging
+BZF_API bool bz_sendTextMessage(int from, int to, const char* message);
+BZF_API bool bz_sendTextMessagef(int from, int to, const char* fmt, ...);
+BZF_API void bz_debugMessage(int level, const char* message);
+BZF_API void bz_debugMessagef(int level, const char* fmt, ...);
+BZF_API int bz_getDebugLevel();
+
+// Utilities
+BZF_API double bz_getCurrentTime();
+BZF_API bz_eGameType bz_getGameType();
+BZF_API const char* bz_format(const char* fmt, ...);
+BZF_API const char* bz_tolower(const char* val);